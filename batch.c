@@ -0,0 +1,241 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// Command line mode for SUBMIT jobs, no screen setup, no key input:
+//   ZMC COPY [d:]pattern d: [d: ...]  (several drives: source read once)
+//   ZMC DEL [d:]pattern      (also ERA)
+//   ZMC LIST [d:][pattern]   (also DIR)
+//   ZMC SYNC d: d:           (copy new and changed files)
+//   ZMC TYPE [d:]file        (also DUMP, without paging)
+// The status is reported as CP/M 3 program return code, on CP/M 2.2
+// an error aborts a running SUBMIT by deleting A:$$$.SUB.
+
+
+// "B:*.BAK" -> drive 'B' ('@' = current), 11 byte FCB pattern
+// and the panel filter, the BDOS search returns only the matching files
+static void parse_spec( const char *spec, Panel *p, uint8_t *pattern ) {
+    p->drive = '@';
+    if ( spec[0] && spec[1] == ':' ) {
+        p->drive = spec[0];
+        spec += 2;
+    }
+    name_to_fcb( pattern, *spec ? spec : "*.*" );
+    *p->filter = '\0';
+    if ( strlen( spec ) < FILENAME_LEN )
+        strcpy( p->filter, spec );
+}
+
+
+static uint8_t pattern[11]; // FCB pattern of the command
+static uint16_t list_files;
+static uint32_t list_recs;
+
+
+// tag all files matching the pattern, starting with file 'first'
+static int batch_tag( Panel *p, uint16_t first ) {
+    uint16_t idx;
+    int n = 0;
+    for ( idx = 0; idx < p->num_files; ++idx )
+        if ( idx >= first && match_name( pattern, p->files[idx].cpmname ) ) {
+            p->files[idx].attrib |= B_SEL;
+            ++n;
+        } else
+            p->files[idx].attrib &= ~B_SEL;
+    return n;
+}
+
+
+// load the directory and tag all files matching the pattern
+static int batch_select( Panel *p, const char *spec ) {
+    parse_spec( spec, p, pattern );
+    if ( p->drive < '@' || p->drive > 'P' )
+        return 0;
+    load_directory( p );
+    return batch_tag( p, 0 );
+}
+
+
+// windowed directory: load and tag the files after the last one,
+// -1 at the end of the directory
+static int batch_next( Panel *p ) {
+    char key[FILENAME_LEN];
+    if ( !p->num_files || p->win_base + p->num_files >= p->total_files )
+        return -1;
+    strcpy( key, p->files[p->num_files - 1].cpmname );
+    load_window( p, key, 0 );
+    // the key file is done, unless it was deleted
+    return batch_tag( p, p->num_files && !name_cmp( p->files[0].cpmname, key ) );
+}
+
+
+static void batch_list( Panel *p ) {
+    uint16_t row;
+    for ( row = 0; row < p->num_files; ++row ) {
+        FileEntry *f = &FILE_AT( p, row );
+        if ( !( f->attrib & B_SEL ) )
+            continue;
+        printf( "%c:%-12s %c%c%c %7lu", p->drive, f->cpmname,
+                f->attrib & B_RO ? 'R' : ' ',
+                f->attrib & B_SYS ? 'S' : ' ',
+                f->attrib & B_ARCH ? 'A' : ' ',
+                (uint32_t)f->extent << 7 );
+        if ( f->date )
+            printf( " %04d-%02d-%02d %02X:%02X",
+                    f->date, f->month, f->day, f->hour, f->minute );
+        putchar( '\n' );
+        list_recs += f->extent;
+        ++list_files;
+    }
+}
+
+
+// run a command line command, return 0 = OK
+int batch( int argc, char **argv ) {
+    char *cmd = *argv;
+    Panel *src = &App.left;
+    Panel *dst = &App.right;
+    int errors = 0;
+    int n;
+    uint16_t files = 0;
+
+    BATCH = 1;
+    App.active_panel = src;
+    src->active = 1;
+
+    // large directories are processed window by window
+    if ( !strcmp( cmd, "LIST" ) || !strcmp( cmd, "DIR" ) ) {
+        batch_select( src, argc > 1 ? argv[1] : "" );
+        do
+            batch_list( src );
+        while ( batch_next( src ) >= 0 );
+        printf( "%u file(s), %luK\n", list_files, ( list_recs + 7 ) >> 3 );
+    } else if ( argc == 2 && ( !strcmp( cmd, "DEL" ) || !strcmp( cmd, "ERA" ) ) ) {
+        n = batch_select( src, argv[1] );
+        do {
+            if ( n ) // nothing tagged would delete the current file
+                errors += exec_multi_delete( src );
+            files += n;
+        } while ( ( n = batch_next( src ) ) >= 0 );
+        if ( !files ) {
+            printf( "No file\n" );
+            return 1;
+        }
+    } else if ( argc > 3 && !strcmp( cmd, "COPY" ) ) { // fan-out to several drives
+        char list[3 * FAN_MAX + 1], drives[FAN_MAX + 1];
+        *list = '\0';
+        for ( n = 2; n < argc && strlen( list ) + strlen( argv[n] ) < sizeof( list ) - 1; ++n ) {
+            strcat( list, argv[n] );
+            strcat( list, " " );
+        }
+        n = batch_select( src, argv[1] );
+        if ( !fan_drives( list, drives, src->drive ) ) {
+            printf( "Destinations must be up to %u other drives\n", FAN_MAX );
+            return 1;
+        }
+        dst->drive = *drives; // scratch panel, its storage is the buffer
+        do {
+            if ( n )
+                errors += exec_fan_copy( src, dst, drives );
+            files += n;
+        } while ( ( n = batch_next( src ) ) >= 0 );
+        if ( !files ) {
+            printf( "No file\n" );
+            return 1;
+        }
+    } else if ( argc == 3 && !strcmp( cmd, "COPY" ) ) {
+        if ( argv[2][0] < 'A' || argv[2][0] > 'P' || argv[2][1] != ':' || argv[2][2] ) {
+            printf( "Destination must be a drive\n" );
+            return 1;
+        }
+        n = batch_select( src, argv[1] );
+        dst->drive = argv[2][0];
+        if ( dst->drive == src->drive ) {
+            printf( "Same drive\n" );
+            return 1;
+        }
+        load_directory( dst );
+        do {
+            if ( n )
+                errors += exec_multi_copy( src, dst );
+            files += n;
+        } while ( ( n = batch_next( src ) ) >= 0 );
+        if ( !files ) {
+            printf( "No file\n" );
+            return 1;
+        }
+    } else if ( argc == 2 && ( !strcmp( cmd, "TYPE" ) || !strcmp( cmd, "DUMP" ) ) ) {
+        if ( !batch_select( src, argv[1] ) ) {
+            printf( "No file\n" );
+            return 1;
+        }
+        while ( !( FILE_AT( src, src->current_idx ).attrib & B_SEL ) )
+            ++src->current_idx; // first matching file
+        if ( *cmd == 'T' )
+            view_file();
+        else
+            dump_file();
+    } else if ( argc == 3 && !strcmp( cmd, "SYNC" ) ) {
+        if ( strlen( argv[1] ) != 2 || argv[1][1] != ':'
+            || strlen( argv[2] ) != 2 || argv[2][1] != ':' ) {
+            printf( "ZMC SYNC d: d:\n" );
+            return 1;
+        }
+        batch_select( src, argv[1] );
+        batch_select( dst, argv[2] );
+        if ( src->drive == dst->drive ) {
+            printf( "Same drive\n" );
+            return 1;
+        }
+        files = compare_panels( src, dst, 0 );
+        if ( files == CMP_WINDOWED ) {
+            printf( "Directory too large to compare\n" );
+            return 1;
+        }
+        if ( files )
+            errors = exec_multi_copy( src, dst );
+    } else {
+        printf( "ZMC COPY [d:]pattern d: [d: ...] | DEL [d:]pattern | LIST [d:][pattern] | SYNC d: d: | TYPE/DUMP [d:]file\n" );
+        return 1;
+    }
+    if ( errors )
+        printf( "%d error(s)\n", errors );
+    return errors != 0;
+}
+
+
+// report the status to SUBMIT
+void batch_exit( int status ) {
+    if ( !status )
+        return;
+    if ( bdos( 12, NULL ) >= 0x30 ) // CP/M 3
+        bdos( 108, 0xFF00 ); // BDOS function 108 (P_CODE) - return code "failure"
+    else { // CP/M 2.2: abort SUBMIT
+        uint8_t fcb[36];
+        memset( fcb, 0, sizeof( fcb ) );
+        *fcb = 1; // A:
+        memcpy( fcb+1, "$$$     SUB", 11 );
+        bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file
+    }
+}
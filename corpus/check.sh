@@ -0,0 +1,114 @@
+#!/bin/bash
+# Run the batch commands of ZMC over the corpus images and compare the
+# costs from ZMC.PRF with budgets.txt, exit status 1 on a regression.
+# usage: check.sh [--update] [--host] [zmc.com]      (default: ../zmc.com)
+#
+# --host runs the ZMC sources built for the host on the emulated CP/M
+# machine of zmchost (mkhost.sh) instead of zmc.com, no Z80 emulator
+# needed. Otherwise the emulator is given as $ZMC_EMU, it is called as
+#   $ZMC_EMU <os> <dir>
+# with os 2 or 3 and runs the SUBMIT job <dir>/JOB.SUB with <dir> as
+# drive A: (ZMC.COM), <dir>/B.img as B: and <dir>/C.img as C:.
+# ZMC.PRF must be back in <dir> after the run.
+# The images are built with mkimages.sh first, see there.
+#
+# --update rewrites budgets.txt with the measured values + 10%.
+# A budget "-" is not measured yet, the run fails without --update.
+
+cd "$(dirname "$0")" || exit 1
+UPDATE=0
+while [ "${1#--}" != "$1" ]; do
+    case $1 in
+        --update) UPDATE=1 ;;
+        --host)   ./mkhost.sh > /dev/null || exit 1
+                  ZMC_EMU=$PWD/zmchost ;;
+        *)        echo "❌ unknown option $1"; exit 1 ;;
+    esac
+    shift
+done
+ZMC=$(realpath "${1:-../zmc.com}")
+IMG=img
+if [ -z "$ZMC_EMU" ]; then
+    echo "❌ ZMC_EMU not set."
+    exit 1
+fi
+[ -f "$IMG/B-zmc16.img" ] || ./mkimages.sh "$IMG" || exit 1
+
+# case -> command line
+case_cmd() {
+    case $1 in
+        list) echo "LIST B:F00*.DAT" ;;
+        type) echo "TYPE B:TEXT.TXT" ;;
+        dump) echo "DUMP B:BIN.COM" ;;
+        copy) echo "COPY B:*.TXT C:" ;;
+        del)  echo "DEL B:F000*.DAT" ;;
+    esac
+}
+
+# value of counter $2 in ZMC.PRF $1
+counter() {
+    tr -d '\r\032' < "$1" | awk -v k="$2" '$1 == k { print $2 }'
+}
+
+RUN=$(mktemp -d)
+trap 'rm -rf "$RUN"' EXIT
+FAIL=0
+UNMEASURED=0
+NEW=$RUN/budgets.txt
+grep '^#' budgets.txt > "$NEW"
+
+while read -r IMAGE CASE BDOS READ WRITE CHARS; do
+    case $IMAGE in ''|'#'*) continue ;; esac
+    OS=2
+    case $IMAGE in *p3) OS=3 ;; esac
+    # fresh images for every case
+    rm -f "$RUN"/*.img "$RUN"/*.PRF "$RUN"/JOB.SUB
+    cp "$ZMC" "$RUN/ZMC.COM"
+    cp "$IMG/B-$IMAGE.img" "$RUN/B.img"
+    cp "$IMG/C-$IMAGE.img" "$RUN/C.img"
+    printf "ZMC --PROFILE %s\r\n\032" "$(case_cmd "$CASE")" > "$RUN/JOB.SUB"
+    $ZMC_EMU $OS "$RUN" > "$RUN/console.log" 2>&1
+    PRF=$RUN/ZMC.PRF
+    if [ ! -f "$PRF" ]; then
+        echo "❌ $IMAGE $CASE: no ZMC.PRF"
+        FAIL=1
+        continue
+    fi
+    LINE=$IMAGE
+    MSG=""
+    NONE=0
+    for K in BDOS READ WRITE CHARS; do
+        V=$(counter "$PRF" $K)
+        V=${V:-0}
+        eval "MAX=\$$K"
+        if [ "$MAX" = "-" ]; then
+            NONE=1
+        elif [ "$V" -gt "$MAX" ]; then
+            MSG="$MSG $K $V > $MAX"
+        fi
+        eval "M_$K=$V"
+    done
+    if [ $NONE = 1 ]; then
+        echo "⚠️  $IMAGE $CASE: no budget yet: BDOS $M_BDOS READ $M_READ WRITE $M_WRITE CHARS $M_CHARS"
+        UNMEASURED=1
+    elif [ -n "$MSG" ]; then
+        echo "❌ $IMAGE $CASE:$MSG"
+        FAIL=1
+    else
+        echo "✅ $IMAGE $CASE: BDOS $M_BDOS READ $M_READ WRITE $M_WRITE CHARS $M_CHARS"
+    fi
+    printf "%-10s %-5s %7d %5d %5d %6d\n" "$IMAGE" "$CASE" \
+        $(( M_BDOS * 11 / 10 )) $(( M_READ * 11 / 10 )) \
+        $(( M_WRITE * 11 / 10 )) $(( M_CHARS * 11 / 10 )) >> "$NEW"
+done < budgets.txt
+
+if [ $UPDATE = 1 ]; then
+    cp "$NEW" budgets.txt
+    echo "budgets.txt updated."
+    exit 0
+fi
+if [ $UNMEASURED = 1 ]; then
+    echo "❌ budgets.txt has cases without a measured budget, run check.sh --update."
+    FAIL=1
+fi
+exit $FAIL
@@ -0,0 +1,12 @@
+// Host build of ZMC for the corpus (see cpmhost.c): the BDOS calls go to
+// the emulated BDOS, an argument is a 16 bit value or a host pointer.
+#ifndef ZMC_HOST_CPM_H
+#define ZMC_HOST_CPM_H
+
+#include <stdint.h>
+
+int host_bdos( int func, intptr_t arg );
+
+#define bdos( func, arg ) host_bdos( (func), (intptr_t)(arg) )
+
+#endif
@@ -0,0 +1,1039 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <ctype.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpm.h"
+#include "malloc.h"
+
+
+// Host harness of the test corpus: the ZMC sources built for the host
+// (mkhost.sh) run on an emulated CP/M machine, check.sh --host uses it
+// in place of a Z80 emulator.
+//   zmchost <os> <dir>                       run <dir>/JOB.SUB, see check.sh
+//   zmchost mkfs.cpm -f fmt [-t] image       the subset of cpmtools that
+//   zmchost cpmcp -f fmt [-p] image file... u:   mkimages.sh needs
+// The 64K of the CP/M machine are mapped at host address 0, so the
+// addresses of ZMC (DMA at 0x80, DPB and ALV from the BDOS, the heap)
+// are the same as on CP/M. The BDOS works on the directory of the image
+// files like the CP/M 2.2 and CP/M 3 BDOS (FCB with the allocation of
+// the current extent, 4 directory entries per record, time stamps on
+// CP/M 3). The formats come from ./diskdefs, without skew.
+
+#define BDOS_ENTRY 0xE406 // JP at 0005h, ZMC --PROFILE replaces it
+#define WBOOT 0xFA03 // BIOS WBOOT entry at 0001h
+#define HEAP_AT 0x0100 // the heap starts in the TPA
+#define HEAP_MAX ( 0xE000 - HEAP_AT )
+#define DPB_AT(d) ( 0xE800 + (d) * 32 )
+#define ALV_AT(d) ( 0xEA00 + (d) * 0x120 ) // 2048 blocks at most
+#define MEM(a) ( (uint8_t *)(uintptr_t)(a) )
+#define DRIVES 16
+#define FORMATS 32
+
+extern uint16_t prof_calls[]; // profile.c
+int zmc_main( int argc, char **argv ); // main.c
+
+
+typedef struct {
+    char name[32];
+    unsigned seclen, tracks, sectrk, blocksize, maxdir, boottrk, skew;
+    uint8_t os; // 2 or 3
+} disk_format;
+
+typedef struct {
+    const disk_format *fmt; // NULL: no disk
+    char path[256];
+    uint8_t *img;
+    size_t size;
+    uint8_t *dir; // block 0, the directory
+    uint8_t bsh, exm, big; // big: 16 bit block numbers
+    unsigned dsm, drm;
+    unsigned hiwater; // entries up to the last one in use
+    uint8_t dirty;
+} drive;
+
+static disk_format formats[FORMATS];
+static int num_formats;
+static drive drives[DRIVES];
+
+static uint8_t cpm_os = 2; // 2.2 or 3
+static uint8_t cur_drive, cur_user;
+static uint8_t *dma;
+static uint16_t login;
+static jmp_buf warm_boot;
+
+// search for first/next: FCB, drive and next entry
+static uint8_t *s_fcb;
+static uint8_t s_drive;
+static unsigned s_pos;
+
+// clock of the machine, also the time stamps of the files
+static uint16_t clk_day; // day 1 = 1.1.1978
+static uint8_t clk_hour, clk_min;
+
+static uint16_t heap_top, heap_end, heap_last;
+
+
+static void fail( const char *fmt, ... ) {
+    va_list ap;
+    va_start( ap, fmt );
+    fputs( "zmchost: ", stderr );
+    vfprintf( stderr, fmt, ap );
+    fputc( '\n', stderr );
+    va_end( ap );
+    exit( 1 );
+}
+
+
+// unix time -> CP/M clock
+static void set_clock( time_t t ) {
+    clk_day = t / 86400 - 2921; // 1.1.1978 is day 2922 of unix time
+    clk_hour = t % 86400 / 3600;
+    clk_min = t % 3600 / 60;
+}
+
+static uint8_t bcd( uint8_t b ) {
+    return ( b / 10 ) << 4 | b % 10;
+}
+
+
+// formats of ./diskdefs, cpmtools syntax
+static void load_formats( void ) {
+    FILE *f = fopen( "diskdefs", "r" );
+    char line[128], key[32], val[32];
+    disk_format *d = NULL;
+    if ( !f )
+        fail( "no ./diskdefs" );
+    while ( fgets( line, sizeof( line ), f ) ) {
+        if ( sscanf( line, "%31s %31s", key, val ) < 1 || *key == '#' )
+            continue;
+        if ( !strcmp( key, "diskdef" ) && num_formats < FORMATS ) {
+            d = &formats[num_formats++];
+            memset( d, 0, sizeof( *d ) );
+            snprintf( d->name, sizeof( d->name ), "%s", val );
+            d->os = 2;
+        } else if ( !strcmp( key, "end" ) )
+            d = NULL;
+        else if ( d && !strcmp( key, "seclen" ) ) d->seclen = atoi( val );
+        else if ( d && !strcmp( key, "tracks" ) ) d->tracks = atoi( val );
+        else if ( d && !strcmp( key, "sectrk" ) ) d->sectrk = atoi( val );
+        else if ( d && !strcmp( key, "blocksize" ) ) d->blocksize = atoi( val );
+        else if ( d && !strcmp( key, "maxdir" ) ) d->maxdir = atoi( val );
+        else if ( d && !strcmp( key, "boottrk" ) ) d->boottrk = atoi( val );
+        else if ( d && !strcmp( key, "skew" ) ) d->skew = atoi( val );
+        else if ( d && !strcmp( key, "os" ) ) d->os = *val == '3' ? 3 : 2;
+    }
+    fclose( f );
+}
+
+static size_t fmt_size( const disk_format *f ) {
+    return (size_t)f->tracks * f->sectrk * f->seclen;
+}
+
+static const disk_format *find_format( const char *name ) {
+    int i;
+    for ( i = 0; i < num_formats; ++i )
+        if ( !strcmp( formats[i].name, name ) )
+            return &formats[i];
+    fail( "format %s not in ./diskdefs", name );
+    return NULL;
+}
+
+// an image is known by its size
+static const disk_format *size_format( size_t size, uint8_t os ) {
+    int i;
+    for ( i = 0; i < num_formats; ++i )
+        if ( fmt_size( &formats[i] ) == size && formats[i].os == os )
+            return &formats[i];
+    return NULL;
+}
+
+
+// the CP/M memory, the zero page and the heap
+static void map_memory( void ) {
+    const char *h = getenv( "ZMC_HEAP" );
+    unsigned heap = h ? atoi( h ) : 16384;
+    if ( mmap( (void *)0, 0x10000, PROT_READ | PROT_WRITE,
+               MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) != (void *)0 )
+        fail( "cannot map the CP/M memory at address 0 (root or vm.mmap_min_addr=0)" );
+    MEM( 0 )[0] = 0xC3; // JP WBOOT
+    *(uint16_t *)MEM( 1 ) = WBOOT;
+    MEM( 5 )[0] = 0xC3; // JP BDOS
+    *(uint16_t *)MEM( 6 ) = BDOS_ENTRY;
+    dma = MEM( 0x80 );
+    heap_top = heap_last = HEAP_AT;
+    heap_end = HEAP_AT + ( heap > HEAP_MAX ? HEAP_MAX : heap );
+}
+
+
+// ---- allocation vector, directory ----
+
+static uint8_t *alv( uint8_t d ) {
+    return MEM( ALV_AT( d ) );
+}
+
+static void alv_set( uint8_t d, unsigned b, int on ) {
+    if ( on )
+        alv( d )[b >> 3] |= 0x80 >> ( b & 7 );
+    else
+        alv( d )[b >> 3] &= ~( 0x80 >> ( b & 7 ) );
+}
+
+static uint8_t *entry( drive *dv, unsigned i ) {
+    return dv->dir + i * 32;
+}
+
+// block number in slot s of the allocation of a FCB or entry
+static unsigned map_get( drive *dv, const uint8_t *e, unsigned s ) {
+    return dv->big ? e[16 + 2 * s] | e[17 + 2 * s] << 8 : e[16 + s];
+}
+
+static void map_set( drive *dv, uint8_t *e, unsigned s, unsigned b ) {
+    if ( dv->big ) {
+        e[16 + 2 * s] = b;
+        e[17 + 2 * s] = b >> 8;
+    } else
+        e[16 + s] = b;
+}
+
+static uint8_t *block( drive *dv, unsigned b ) {
+    return dv->dir + (size_t)b * dv->fmt->blocksize;
+}
+
+// DPB and ALV of drive d, as the BDOS has them after the login
+static void login_drive( uint8_t d ) {
+    drive *dv = &drives[d];
+    const disk_format *f = dv->fmt;
+    uint8_t *dpb = MEM( DPB_AT( d ) );
+    unsigned dirblocks = ( f->maxdir * 32 + f->blocksize - 1 ) / f->blocksize;
+    unsigned i, s, mask = 0xFFFF << ( 16 - dirblocks );
+
+    dv->bsh = __builtin_ctz( f->blocksize / 128 );
+    dv->dsm = ( f->tracks - f->boottrk ) * f->sectrk * f->seclen / f->blocksize - 1;
+    dv->drm = f->maxdir - 1;
+    dv->big = dv->dsm > 255;
+    dv->exm = f->blocksize / ( dv->big ? 2048 : 1024 ) - 1;
+    dv->dir = dv->img + (size_t)f->boottrk * f->sectrk * f->seclen;
+
+    *(uint16_t *)dpb = f->sectrk * f->seclen / 128; // SPT
+    dpb[2] = dv->bsh;
+    dpb[3] = ( 1 << dv->bsh ) - 1; // BLM
+    dpb[4] = dv->exm;
+    *(uint16_t *)( dpb + 5 ) = dv->dsm;
+    *(uint16_t *)( dpb + 7 ) = dv->drm;
+    dpb[9] = mask >> 8; // AL0, AL1
+    dpb[10] = mask;
+    *(uint16_t *)( dpb + 11 ) = 0; // CKS, fixed disk
+    *(uint16_t *)( dpb + 13 ) = f->boottrk; // OFF
+    dpb[15] = __builtin_ctz( f->seclen / 128 ); // PSH, PHM
+    dpb[16] = f->seclen / 128 - 1;
+
+    memset( alv( d ), 0, 0x120 );
+    for ( i = 0; i < dirblocks; ++i )
+        alv_set( d, i, 1 );
+    dv->hiwater = 0;
+    for ( i = 0; i <= dv->drm; ++i ) {
+        uint8_t *e = entry( dv, i );
+        if ( *e == 0xE5 )
+            continue;
+        dv->hiwater = i + 1;
+        if ( *e < 0x20 ) // files, not labels, time stamps, passwords
+            for ( s = 0; s < ( dv->big ? 8u : 16u ); ++s )
+                if ( map_get( dv, e, s ) )
+                    alv_set( d, map_get( dv, e, s ), 1 );
+    }
+    login |= 1 << d;
+}
+
+static void mount( uint8_t d, const char *path, const disk_format *f ) {
+    drive *dv = &drives[d];
+    FILE *fp = fopen( path, "rb" );
+    if ( !fp )
+        fail( "cannot read %s", path );
+    snprintf( dv->path, sizeof( dv->path ), "%s", path );
+    dv->fmt = f;
+    dv->size = fmt_size( f );
+    dv->img = malloc( dv->size );
+    if ( !dv->img || fread( dv->img, 1, dv->size, fp ) != dv->size )
+        fail( "cannot read %s", path );
+    fclose( fp );
+    if ( f->skew )
+        fail( "%s: formats with skew are not supported", f->name );
+    dv->dirty = 0;
+    login_drive( d );
+}
+
+static void unmount_all( void ) {
+    uint8_t d;
+    for ( d = 0; d < DRIVES; ++d ) {
+        drive *dv = &drives[d];
+        FILE *fp;
+        if ( !dv->fmt || !dv->dirty )
+            continue;
+        fp = fopen( dv->path, "wb" );
+        if ( !fp || fwrite( dv->img, 1, dv->size, fp ) != dv->size || fclose( fp ) )
+            fail( "cannot write %s", dv->path );
+        dv->dirty = 0;
+    }
+}
+
+
+// ---- files ----
+
+// drive of a FCB, NULL if there is no disk
+static drive *fcb_drive( const uint8_t *fcb, uint8_t *d ) {
+    *d = fcb[0] && fcb[0] != '?' ? ( fcb[0] - 1 ) & 0x0F : cur_drive;
+    return drives[*d].fmt ? &drives[*d] : NULL;
+}
+
+// the entry belongs to the file of the FCB, '?' matches any character,
+// ext: also the extent (EX within the extent mask, S2)
+static int fcb_match( drive *dv, const uint8_t *fcb, const uint8_t *e, int ext ) {
+    unsigned i;
+    if ( e[0] != cur_user )
+        return 0;
+    for ( i = 1; i < 12; ++i )
+        if ( fcb[i] != '?' && ( ( fcb[i] ^ e[i] ) & 0x7F ) )
+            return 0;
+    if ( !ext )
+        return 1;
+    if ( fcb[12] != '?' && ( ( fcb[12] ^ e[12] ) & ~dv->exm & 0x1F ) )
+        return 0;
+    return fcb[14] == '?' || !( ( fcb[14] ^ e[14] ) & 0x7F );
+}
+
+static int find_entry( drive *dv, const uint8_t *fcb, int ext ) {
+    unsigned i;
+    for ( i = 0; i < dv->hiwater; ++i )
+        if ( fcb_match( dv, fcb, entry( dv, i ), ext ) )
+            return i;
+    return -1;
+}
+
+// CP/M 3 time stamp of entry i: create or update, as the label says
+static void stamp( drive *dv, unsigned i, int update ) {
+    uint8_t *label = entry( dv, 0 ), *s = entry( dv, i | 3 ), *t;
+    if ( dv->fmt->os != 3 || label[0] != 0x20 || s[0] != 0x21 || ( i & 3 ) == 3
+         || !( label[12] & ( update ? 0x20 : 0x10 ) ) )
+        return;
+    t = s + 1 + ( i & 3 ) * 10 + ( update ? 4 : 0 );
+    t[0] = clk_day;
+    t[1] = clk_day >> 8;
+    t[2] = bcd( clk_hour );
+    t[3] = bcd( clk_min );
+}
+
+// the stamps are in the entry of the first extent
+static void stamp_file( drive *dv, const uint8_t *fcb, int update ) {
+    uint8_t first[16];
+    int i;
+    memcpy( first, fcb, 16 );
+    first[12] = first[14] = 0;
+    if ( ( i = find_entry( dv, first, 1 ) ) >= 0 )
+        stamp( dv, i, update );
+}
+
+// BDOS 15: the FCB gets the entry of its extent, the records of the
+// extent in RC, S2 bit 7 = not modified
+static int f_open( drive *dv, uint8_t *fcb ) {
+    int i = find_entry( dv, fcb, 1 );
+    uint8_t ex = fcb[12], *e;
+    if ( i < 0 )
+        return 255;
+    e = entry( dv, i );
+    memcpy( fcb + 1, e + 1, 31 );
+    fcb[12] = ex;
+    fcb[14] |= 0x80;
+    fcb[15] = ex < e[12] ? 0x80 : ex > e[12] ? 0 : e[15];
+    return i & 3;
+}
+
+// BDOS 16: the allocation and the size go to the directory
+static int f_close( drive *dv, uint8_t *fcb ) {
+    int i;
+    unsigned k;
+    uint8_t *e;
+    if ( fcb[14] & 0x80 ) // not modified
+        return 0;
+    if ( ( i = find_entry( dv, fcb, 1 ) ) < 0 )
+        return 255;
+    e = entry( dv, i );
+    for ( k = 16; k < 32; ++k )
+        if ( !e[k] )
+            e[k] = fcb[k];
+    if ( fcb[12] > e[12] || ( fcb[12] == e[12] && fcb[15] > e[15] ) ) {
+        e[12] = fcb[12];
+        e[15] = fcb[15];
+    }
+    dv->dirty = 1;
+    stamp_file( dv, fcb, 1 );
+    return i & 3;
+}
+
+// BDOS 22: a new entry for the extent of the FCB
+static int f_make( drive *dv, uint8_t *fcb ) {
+    unsigned i, k;
+    uint8_t *e;
+    for ( i = 0; i <= dv->drm && *entry( dv, i ) != 0xE5; ++i )
+        ;
+    if ( i > dv->drm )
+        return 255;
+    e = entry( dv, i );
+    e[0] = cur_user;
+    for ( k = 1; k < 12; ++k )
+        e[k] = fcb[k] & 0x7F;
+    e[12] = fcb[12] & 0x1F;
+    e[13] = 0;
+    e[14] = fcb[14] & 0x7F;
+    e[15] = 0;
+    memset( e + 16, 0, 16 );
+    fcb[13] = 0;
+    fcb[14] &= 0x7F; // modified
+    fcb[15] = 0;
+    memset( fcb + 16, 0, 16 );
+    if ( i >= dv->hiwater )
+        dv->hiwater = i + 1;
+    dv->dirty = 1;
+    if ( !( e[12] & ~dv->exm ) && !e[14] )
+        stamp( dv, i, 0 );
+    return i & 3;
+}
+
+// BDOS 19: all extents of the matching files
+static int f_delete( drive *dv, uint8_t d, const uint8_t *fcb ) {
+    unsigned i, s;
+    int rc = 255;
+    for ( i = 0; i < dv->hiwater; ++i ) {
+        uint8_t *e = entry( dv, i );
+        if ( !fcb_match( dv, fcb, e, 0 ) )
+            continue;
+        for ( s = 0; s < ( dv->big ? 8u : 16u ); ++s )
+            if ( map_get( dv, e, s ) )
+                alv_set( d, map_get( dv, e, s ), 0 );
+        *e = 0xE5;
+        dv->dirty = 1;
+        rc = i & 3;
+    }
+    return rc;
+}
+
+// BDOS 23: the name at FCB+16 for all extents
+static int f_rename( drive *dv, const uint8_t *fcb ) {
+    unsigned i, k;
+    int rc = 255;
+    for ( i = 0; i < dv->hiwater; ++i ) {
+        uint8_t *e = entry( dv, i );
+        if ( !fcb_match( dv, fcb, e, 0 ) )
+            continue;
+        for ( k = 1; k < 12; ++k )
+            e[k] = ( e[k] & 0x80 ) | ( fcb[16 + k] & 0x7F );
+        dv->dirty = 1;
+        rc = i & 3;
+    }
+    return rc;
+}
+
+// BDOS 17/18: the record of the next matching entry to the DMA,
+// '?' as drive: every entry up to the last one in use
+static int f_search( void ) {
+    drive *dv = &drives[s_drive];
+    if ( !dv->fmt )
+        return 255;
+    for ( ; s_pos < ( *s_fcb == '?' ? dv->hiwater : dv->drm + 1 ); ++s_pos )
+        if ( *s_fcb == '?' || fcb_match( dv, s_fcb, entry( dv, s_pos ), 1 ) ) {
+            memcpy( dma, entry( dv, s_pos & ~3 ), 128 );
+            return s_pos++ & 3;
+        }
+    return 255;
+}
+
+// close the extent of the FCB, open the next one, a write makes it,
+// returns 1 at the end of the file or if the directory is full
+static int next_extent( drive *dv, uint8_t *fcb, int write ) {
+    if ( f_close( dv, fcb ) == 255 )
+        return 1;
+    if ( ++fcb[12] == 32 ) {
+        fcb[12] = 0;
+        fcb[14] = ( fcb[14] & 0x7F ) + 1;
+    }
+    fcb[32] = 0;
+    if ( f_open( dv, fcb ) != 255 )
+        return 0;
+    return !write || f_make( dv, fcb ) == 255;
+}
+
+// the record CR of the extent in the FCB
+static uint8_t *record( drive *dv, uint8_t *fcb, int alloc, int zero, uint8_t d ) {
+    unsigned r = ( ( fcb[12] & dv->exm ) << 7 ) + fcb[32];
+    unsigned s = r >> dv->bsh, b = map_get( dv, fcb, s );
+    if ( !b && alloc ) {
+        for ( b = 0; b <= dv->dsm && ( alv( d )[b >> 3] & ( 0x80 >> ( b & 7 ) ) ); ++b )
+            ;
+        if ( b > dv->dsm )
+            return NULL;
+        alv_set( d, b, 1 );
+        map_set( dv, fcb, s, b );
+        if ( zero )
+            memset( block( dv, b ), 0, dv->fmt->blocksize );
+    }
+    return b ? block( dv, b ) + ( ( r & ( ( 1 << dv->bsh ) - 1 ) ) << 7 ) : NULL;
+}
+
+static int rec_read( drive *dv, uint8_t *fcb, uint8_t d ) {
+    uint8_t *p;
+    if ( fcb[32] >= fcb[15] || !( p = record( dv, fcb, 0, 0, d ) ) )
+        return 1; // reading unwritten data
+    memcpy( dma, p, 128 );
+    return 0;
+}
+
+static int rec_write( drive *dv, uint8_t *fcb, int zero, uint8_t d ) {
+    uint8_t *p = record( dv, fcb, 1, zero, d );
+    if ( !p )
+        return 2; // disk full
+    memcpy( p, dma, 128 );
+    if ( fcb[32] >= fcb[15] )
+        fcb[15] = fcb[32] + 1;
+    fcb[14] &= 0x7F;
+    dv->dirty = 1;
+    return 0;
+}
+
+// random record R0/R1 -> extent and CR
+static int rand_seek( drive *dv, uint8_t *fcb, int write ) {
+    unsigned r = fcb[33] | fcb[34] << 8;
+    uint8_t ex = ( r >> 7 ) & 0x1F, s2 = r >> 12;
+    if ( fcb[35] )
+        return 6; // random record number out of range
+    fcb[32] = r & 0x7F;
+    if ( ex == fcb[12] && s2 == ( fcb[14] & 0x7F ) )
+        return 0;
+    if ( f_close( dv, fcb ) == 255 )
+        return 3; // cannot close current extent
+    fcb[12] = ex;
+    fcb[14] = s2;
+    if ( f_open( dv, fcb ) != 255 )
+        return 0;
+    if ( !write )
+        return 4; // seek to unwritten extent
+    return f_make( dv, fcb ) == 255 ? 5 : 0; // directory full
+}
+
+// BDOS 35: records of the file, the end of its last extent
+static void f_size( drive *dv, uint8_t *fcb ) {
+    unsigned i;
+    uint32_t size = 0, n;
+    for ( i = 0; i < dv->hiwater; ++i ) {
+        uint8_t *e = entry( dv, i );
+        if ( !fcb_match( dv, fcb, e, 0 ) )
+            continue;
+        n = ( ( e[14] & 0x3F ) * 32 + e[12] ) * 128u + e[15];
+        if ( n > size )
+            size = n;
+    }
+    fcb[33] = size;
+    fcb[34] = size >> 8;
+    fcb[35] = size >> 16;
+}
+
+
+// ---- BDOS ----
+
+static void con_out( uint8_t c ) {
+    putchar( c );
+}
+
+int host_bdos( int func, intptr_t arg ) {
+    uint8_t *fcb = (uint8_t *)arg, d;
+    drive *dv;
+    int rc;
+
+    if ( *(uint16_t *)MEM( 6 ) != BDOS_ENTRY && func >= 0 && func < 128 )
+        ++prof_calls[func]; // the --PROFILE hook is in front of the BDOS
+    if ( cpm_os == 2 && func > 40 )
+        return 0; // not in CP/M 2.2
+
+    switch ( func ) {
+    case 0: // P_TERMCPM
+        longjmp( warm_boot, 1 );
+    case 2: // C_WRITE
+        con_out( arg );
+        return 0;
+    case 6: // C_RAWIO, no keys
+        if ( ( arg & 0xFF ) < 0xFD )
+            con_out( arg );
+        return 0;
+    case 9: // C_WRITESTR
+        while ( *fcb != '$' )
+            con_out( *fcb++ );
+        return 0;
+    case 10: // C_READSTR, an empty line
+        fcb[1] = 0;
+        return 0;
+    case 12: // S_BDOSVER
+        return cpm_os == 3 ? 0x31 : 0x22;
+    case 13: // DRV_ALLRESET
+        login = 0;
+        cur_drive = 0;
+        dma = MEM( 0x80 );
+        return 0;
+    case 14: // DRV_SET
+        if ( !drives[arg & 0x0F].fmt )
+            return 255;
+        cur_drive = arg & 0x0F;
+        login |= 1 << cur_drive;
+        return 0;
+    case 15: // F_OPEN
+        return ( dv = fcb_drive( fcb, &d ) ) ? f_open( dv, fcb ) : 255;
+    case 16: // F_CLOSE
+        return ( dv = fcb_drive( fcb, &d ) ) ? f_close( dv, fcb ) : 255;
+    case 17: // F_SFIRST
+        s_fcb = fcb;
+        fcb_drive( fcb, &s_drive );
+        s_pos = 0;
+        return f_search();
+    case 18: // F_SNEXT
+        return s_fcb ? f_search() : 255;
+    case 19: // F_DELETE
+        return ( dv = fcb_drive( fcb, &d ) ) ? f_delete( dv, d, fcb ) : 255;
+    case 20: // F_READ
+        if ( !( dv = fcb_drive( fcb, &d ) ) )
+            return 255;
+        if ( fcb[32] == 128 && next_extent( dv, fcb, 0 ) )
+            return 1;
+        if ( rec_read( dv, fcb, d ) )
+            return 1;
+        ++fcb[32];
+        return 0;
+    case 21: // F_WRITE
+        if ( !( dv = fcb_drive( fcb, &d ) ) )
+            return 255;
+        if ( fcb[32] == 128 && next_extent( dv, fcb, 1 ) )
+            return 1;
+        if ( ( rc = rec_write( dv, fcb, 0, d ) ) )
+            return rc;
+        ++fcb[32];
+        return 0;
+    case 22: // F_MAKE
+        return ( dv = fcb_drive( fcb, &d ) ) ? f_make( dv, fcb ) : 255;
+    case 23: // F_RENAME
+        return ( dv = fcb_drive( fcb, &d ) ) ? f_rename( dv, fcb ) : 255;
+    case 24: // DRV_LOGINVEC
+        return login;
+    case 25: // DRV_GET
+        return cur_drive;
+    case 26: // F_DMAOFF
+        dma = (uint8_t *)arg;
+        return 0;
+    case 27: // DRV_ALLOCVEC
+        return ALV_AT( cur_drive );
+    case 29: // DRV_ROVEC
+        return 0;
+    case 31: // DRV_DPB
+        return DPB_AT( cur_drive );
+    case 32: // F_USERNUM
+        if ( ( arg & 0xFF ) == 0xFF )
+            return cur_user;
+        cur_user = arg & 0x0F;
+        return 0;
+    case 33: // F_READRAND
+    case 34: // F_WRITERAND
+    case 40: // F_WRITEZF
+        if ( !( dv = fcb_drive( fcb, &d ) ) )
+            return 255;
+        if ( ( rc = rand_seek( dv, fcb, func != 33 ) ) )
+            return rc;
+        return func == 33 ? rec_read( dv, fcb, d ) : rec_write( dv, fcb, func == 40, d );
+    case 35: // F_SIZE
+        if ( ( dv = fcb_drive( fcb, &d ) ) )
+            f_size( dv, fcb );
+        return 0;
+    case 36: { // F_RANDREC
+        unsigned r = ( ( fcb[14] & 0x7F ) * 32 + fcb[12] ) * 128 + fcb[32];
+        fcb[33] = r;
+        fcb[34] = r >> 8;
+        fcb[35] = 0;
+        return 0;
+    }
+    case 46: { // DRV_SPACE, free records at the DMA
+        uint32_t b, n = 0;
+        dv = &drives[arg & 0x0F];
+        if ( !dv->fmt )
+            return 255;
+        for ( b = 0; b <= dv->dsm; ++b )
+            n += !( alv( arg & 0x0F )[b >> 3] & ( 0x80 >> ( b & 7 ) ) );
+        n <<= dv->bsh;
+        dma[0] = n;
+        dma[1] = n >> 8;
+        dma[2] = n >> 16;
+        return 0;
+    }
+    case 49: // S_SYSVAR, get: columns - 1, lines - 1
+        return fcb[1] ? 0 : fcb[0] == 0x1A ? 79 : fcb[0] == 0x1C ? 23 : 0;
+    case 105: // T_GET
+        fcb[0] = clk_day;
+        fcb[1] = clk_day >> 8;
+        fcb[2] = bcd( clk_hour );
+        fcb[3] = bcd( clk_min );
+        return 0; // seconds
+    default: // console input (no keys), errors modes, flush, return code
+        return 0;
+    }
+}
+
+uint16_t bdos_hl( uint8_t func, uint16_t arg ) {
+    return host_bdos( func, arg );
+}
+
+// BIOS: no key pressed, no disk access
+uint16_t bios_direct( uint8_t func, uint16_t bc, uint16_t de ) {
+    return 0;
+}
+
+
+// ---- console of the z88dk library: LF as CR LF, through the BDOS ----
+
+// z88dk has a 32 bit long, the host 64 bit: "%lu" -> "%u" (the values
+// are in the low half of the argument)
+static const char *fmt_host( const char *fmt, char *buf, size_t len ) {
+    char *p = buf;
+    while ( *fmt && p < buf + len - 1 ) {
+        if ( ( *p++ = *fmt++ ) != '%' )
+            continue;
+        for ( ; *fmt && strchr( "-+ #0123456789.l", *fmt ); ++fmt )
+            if ( *fmt != 'l' && p < buf + len - 1 )
+                *p++ = *fmt;
+        if ( *fmt && p < buf + len - 1 )
+            *p++ = *fmt++;
+    }
+    *p = '\0';
+    return buf;
+}
+
+int host_putchar( int c ) {
+    if ( c == '\n' )
+        host_bdos( 2, '\r' );
+    host_bdos( 2, c & 0xFF );
+    return c;
+}
+
+static int con_vprintf( const char *fmt, va_list ap ) {
+    char f[256], buf[1024];
+    int n = vsnprintf( buf, sizeof( buf ), fmt_host( fmt, f, sizeof( f ) ), ap ), i;
+    for ( i = 0; i < n && buf[i]; ++i )
+        host_putchar( (uint8_t)buf[i] );
+    return n;
+}
+
+int host_printf( const char *fmt, ... ) {
+    va_list ap;
+    int n;
+    va_start( ap, fmt );
+    n = con_vprintf( fmt, ap );
+    va_end( ap );
+    return n;
+}
+
+int host_fprintf( FILE *f, const char *fmt, ... ) { // stdout and stderr
+    va_list ap;
+    int n;
+    va_start( ap, fmt );
+    n = con_vprintf( fmt, ap );
+    va_end( ap );
+    return n;
+}
+
+int host_fputs( const char *s, FILE *f ) {
+    while ( *s )
+        host_putchar( (uint8_t)*s++ );
+    return 0;
+}
+
+int host_puts( const char *s ) {
+    host_fputs( s, stdout );
+    host_putchar( '\n' );
+    return 0;
+}
+
+int host_sprintf( char *buf, const char *fmt, ... ) {
+    char f[256];
+    va_list ap;
+    int n;
+    va_start( ap, fmt );
+    n = vsprintf( buf, fmt_host( fmt, f, sizeof( f ) ), ap );
+    va_end( ap );
+    return n;
+}
+
+
+// ---- heap in the TPA, the blocks of ZMC are never given back ----
+
+void mallinfo( uint16_t *total, uint16_t *largest ) {
+    *total = *largest = heap_end - heap_top;
+}
+
+void *cpm_malloc( size_t size ) {
+    if ( size > (size_t)( heap_end - heap_top ) )
+        return NULL;
+    heap_last = heap_top;
+    heap_top += size;
+    return MEM( heap_last );
+}
+
+void *cpm_calloc( size_t n, size_t size ) {
+    void *p = n && size > 0xFFFF / n ? NULL : cpm_malloc( n * size );
+    if ( p )
+        memset( p, 0, n * size );
+    return p;
+}
+
+void cpm_free( void *p ) {
+    if ( p == MEM( heap_last ) )
+        heap_top = heap_last;
+}
+
+
+// ---- the tools ----
+
+// "name.ext" -> FCB name, upper case
+static void host_fcb( uint8_t *fcb, const char *name ) {
+    unsigned i;
+    const char *dot = strrchr( name, '.' );
+    memset( fcb, 0, 36 );
+    memset( fcb + 1, ' ', 11 );
+    for ( i = 0; i < 8 && name[i] && name + i != dot; ++i )
+        fcb[1 + i] = toupper( (uint8_t)name[i] );
+    for ( i = 0; dot && i < 3 && dot[1 + i]; ++i )
+        fcb[9 + i] = toupper( (uint8_t)dot[1 + i] );
+}
+
+// mkfs.cpm -f fmt [-t] image: an empty disk, with -t a label and
+// a time stamp entry in every 4th entry
+static int do_mkfs( int argc, char **argv ) {
+    const disk_format *f = NULL;
+    const char *path = NULL;
+    int i, stamps = 0;
+    size_t size, dir;
+    uint8_t *img, *e;
+    FILE *fp;
+
+    for ( i = 1; i < argc; ++i )
+        if ( !strcmp( argv[i], "-f" ) && i + 1 < argc )
+            f = find_format( argv[++i] );
+        else if ( !strcmp( argv[i], "-t" ) )
+            stamps = 1;
+        else
+            path = argv[i];
+    if ( !f || !path )
+        fail( "usage: mkfs.cpm -f fmt [-t] image" );
+    size = fmt_size( f );
+    dir = (size_t)f->boottrk * f->sectrk * f->seclen;
+    img = malloc( size );
+    memset( img, 0xE5, size );
+    if ( stamps ) {
+        for ( i = 3; i < (int)f->maxdir; i += 4 ) {
+            e = img + dir + i * 32;
+            memset( e, 0, 32 );
+            e[0] = 0x21;
+        }
+        e = img + dir;
+        memset( e, 0, 32 );
+        e[0] = 0x20;
+        memcpy( e + 1, "ZMC        ", 11 );
+        e[12] = 0x31; // label, stamps on create and update
+        e[24] = e[28] = clk_day;
+        e[25] = e[29] = clk_day >> 8;
+        e[26] = e[30] = bcd( clk_hour );
+        e[27] = e[31] = bcd( clk_min );
+    }
+    fp = fopen( path, "wb" );
+    if ( !fp || fwrite( img, 1, size, fp ) != size || fclose( fp ) )
+        fail( "cannot write %s", path );
+    free( img );
+    return 0;
+}
+
+// cpmcp -f fmt [-p] image file... u: the files through the BDOS, -p
+// stamps them with their modification time
+static int do_cpmcp( int argc, char **argv ) {
+    const disk_format *f = NULL;
+    const char *path = NULL;
+    int i, first = 0, keep = 0;
+    uint8_t fcb[36];
+
+    for ( i = 1; i < argc && !first; ++i )
+        if ( !strcmp( argv[i], "-f" ) && i + 1 < argc )
+            f = find_format( argv[++i] );
+        else if ( !strcmp( argv[i], "-p" ) )
+            keep = 1;
+        else if ( !path )
+            path = argv[i];
+        else
+            first = i;
+    if ( !f || !path || !first || first >= argc - 1 )
+        fail( "usage: cpmcp -f fmt [-p] image file... u:" );
+    cpm_os = f->os;
+    mount( 0, path, f );
+    cur_user = atoi( argv[argc - 1] ) & 0x0F;
+    for ( i = first; i < argc - 1; ++i ) {
+        const char *base = strrchr( argv[i], '/' );
+        FILE *fp = fopen( argv[i], "rb" );
+        struct stat st;
+        size_t n;
+        if ( !fp || fstat( fileno( fp ), &st ) )
+            fail( "cannot read %s", argv[i] );
+        if ( keep )
+            set_clock( st.st_mtime );
+        host_fcb( fcb, base ? base + 1 : argv[i] );
+        bdos( 19, fcb );
+        if ( bdos( 22, fcb ) == 255 )
+            fail( "%s: directory full", path );
+        while ( ( n = fread( dma, 1, 128, fp ) ) ) {
+            memset( dma + n, 0x1A, 128 - n );
+            if ( bdos( 21, fcb ) )
+                fail( "%s: disk full", path );
+        }
+        bdos( 16, fcb );
+        fclose( fp );
+    }
+    unmount_all();
+    return 0;
+}
+
+// mount <dir>/<x>.img as drive d, by size in the format of os
+static void mount_image( uint8_t d, const char *dir, char x, uint8_t os ) {
+    char path[256];
+    struct stat st;
+    const disk_format *f;
+    snprintf( path, sizeof( path ), "%s/%c.img", dir, x );
+    if ( stat( path, &st ) )
+        return;
+    if ( !( f = size_format( st.st_size, os ) ) )
+        fail( "%s: no CP/M %u format of that size in ./diskdefs", path, os );
+    mount( d, path, f );
+}
+
+// one command line of the job, in its own process
+static void run_line( char *line, const char *dir, uint8_t os ) {
+    char *argv[32], *p;
+    int argc = 0;
+    pid_t pid;
+
+    for ( p = line; *p; ++p )
+        *p = toupper( (uint8_t)*p );
+    for ( p = strtok( line, " \t" ); p && argc < 31; p = strtok( NULL, " \t" ) )
+        argv[argc++] = p;
+    argv[argc] = NULL;
+    if ( !argc )
+        return;
+    printf( "A>%s", argv[0] );
+    for ( int i = 1; i < argc; ++i )
+        printf( " %s", argv[i] );
+    printf( "\r\n" );
+    if ( strcmp( argv[0], "ZMC" ) ) {
+        printf( "%s?\r\n", argv[0] );
+        return;
+    }
+    fflush( stdout );
+    if ( ( pid = fork() ) < 0 )
+        fail( "fork" );
+    if ( pid ) {
+        waitpid( pid, NULL, 0 );
+        return;
+    }
+    map_memory();
+    mount_image( 0, dir, 'A', os );
+    mount_image( 1, dir, 'B', os );
+    mount_image( 2, dir, 'C', os );
+    login = 1; // A:
+    if ( !setjmp( warm_boot ) )
+        zmc_main( argc, argv );
+    fflush( stdout );
+    unmount_all();
+    _exit( 0 );
+}
+
+// zmchost <os> <dir>: the SUBMIT job, then ZMC.PRF from A: to <dir>
+static int do_run( uint8_t os, const char *dir ) {
+    char path[256], job[4096], *line, *next;
+    char *mkfs[] = { "mkfs.cpm", "-f", os == 3 ? "zmc512p3" : "zmc512", path, "-t", NULL };
+    uint8_t fcb[36];
+    FILE *fp;
+    size_t n;
+
+    snprintf( path, sizeof( path ), "%s/JOB.SUB", dir );
+    if ( !( fp = fopen( path, "rb" ) ) )
+        fail( "cannot read %s", path );
+    n = fread( job, 1, sizeof( job ) - 1, fp );
+    fclose( fp );
+    job[n] = '\0';
+    if ( ( line = strchr( job, 0x1A ) ) )
+        *line = '\0';
+
+    snprintf( path, sizeof( path ), "%s/A.img", dir ); // A: holds ZMC.PRF
+    if ( access( path, F_OK ) )
+        do_mkfs( os == 3 ? 5 : 4, mkfs );
+    cpm_os = os;
+    for ( line = job; line; line = next ) {
+        if ( ( next = strpbrk( line, "\r\n" ) ) )
+            *next++ = '\0';
+        run_line( line, dir, os );
+    }
+
+    map_memory();
+    mount_image( 0, dir, 'A', os );
+    host_fcb( fcb, "ZMC.PRF" );
+    if ( bdos( 15, fcb ) == 255 )
+        return 0;
+    snprintf( path, sizeof( path ), "%s/ZMC.PRF", dir );
+    if ( !( fp = fopen( path, "wb" ) ) )
+        fail( "cannot write %s", path );
+    while ( !bdos( 20, fcb ) )
+        fwrite( dma, 1, 128, fp );
+    fclose( fp );
+    return 0;
+}
+
+
+int main( int argc, char **argv ) {
+    set_clock( 1767268800 ); // 2026-01-01 12:00
+    load_formats();
+    if ( argc > 1 && !strcmp( argv[1], "mkfs.cpm" ) ) {
+        map_memory();
+        return do_mkfs( argc - 1, argv + 1 );
+    }
+    if ( argc > 1 && !strcmp( argv[1], "cpmcp" ) ) {
+        map_memory();
+        return do_cpmcp( argc - 1, argv + 1 );
+    }
+    if ( argc == 3 && ( !strcmp( argv[1], "2" ) || !strcmp( argv[1], "3" ) ) )
+        return do_run( *argv[1] - '0', argv[2] );
+    fprintf( stderr, "usage: zmchost 2|3 dir | mkfs.cpm -f fmt [-t] image"
+             " | cpmcp -f fmt [-p] image file... u:\n" );
+    return 1;
+}
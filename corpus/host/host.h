@@ -0,0 +1,38 @@
+// Host build of ZMC for the corpus (see cpmhost.c), included before every
+// source file: the library headers first, then the console output goes
+// through the emulated BDOS like the z88dk CP/M console driver, and the
+// structures are packed like the ones of sccz80.
+#ifndef ZMC_HOST_H
+#define ZMC_HOST_H
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpm.h"
+#include "malloc.h"
+
+int host_printf( const char *fmt, ... );
+int host_fprintf( FILE *f, const char *fmt, ... );
+int host_putchar( int c );
+int host_puts( const char *s );
+int host_fputs( const char *s, FILE *f );
+int host_sprintf( char *buf, const char *fmt, ... );
+
+#define printf host_printf
+#define fprintf host_fprintf
+#define putchar host_putchar
+#define puts host_puts
+#define fputs host_fputs
+#define sprintf host_sprintf
+#define malloc cpm_malloc
+#define calloc cpm_calloc
+#define free cpm_free
+
+#pragma pack(1)
+
+#endif
@@ -0,0 +1,14 @@
+// Host build of ZMC for the corpus (see cpmhost.c): the heap is a fixed
+// block in the CP/M memory, as large as $ZMC_HEAP (default 16K).
+#ifndef ZMC_HOST_MALLOC_H
+#define ZMC_HOST_MALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void mallinfo( uint16_t *total, uint16_t *largest );
+void *cpm_malloc( size_t size );
+void *cpm_calloc( size_t n, size_t size );
+void cpm_free( void *p );
+
+#endif
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Build zmchost: the ZMC sources of the Makefile for the host, on the
+# emulated CP/M machine of host/cpmhost.c (see there), for check.sh --host
+# and for mkimages.sh without cpmtools.
+# usage: mkhost.sh      (needs gcc, writes ./zmchost)
+#
+# The #asm blocks are left out, kernels.c has C versions with -DNOASM,
+# host/host.h comes first in every source: the console output through
+# the BDOS, the heap in the TPA, packed structures like sccz80.
+
+cd "$(dirname "$0")" || exit 1
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+SRC=$(sed -n 's/^\(ROOT\|OVL_HELP\|OVL_VIEWER\) = //p' ../Makefile)
+CFLAGS="-O2 -w -DNOASM -DAMALLOC -include host/host.h -Ihost -I.. \
+ -fno-strict-aliasing -fwrapv -fno-delete-null-pointer-checks --param=min-pagesize=0"
+
+OBJS=""
+for F in $SRC; do
+    N=${F%.c}
+    awk '/^#asm/ { skip = 1 } !skip { print } /^#endasm/ { skip = 0 }' "../$F" > "$TMP/$F"
+    case $N in
+        main)    DEFS="-Dmain=zmc_main" ;;
+        kernels) DEFS="-Dbdos_hl=asm_bdos_hl -Dbios_direct=asm_bios_direct" ;;
+        *)       DEFS="" ;;
+    esac
+    gcc $CFLAGS $DEFS -c "$TMP/$F" -o "$TMP/$N.o" || exit 1
+    OBJS="$OBJS $TMP/$N.o"
+done
+gcc -O2 -Wall -fno-delete-null-pointer-checks --param=min-pagesize=0 -Ihost -c host/cpmhost.c -o "$TMP/cpmhost.o" || exit 1
+gcc -o zmchost $OBJS "$TMP/cpmhost.o" || exit 1
+echo "zmchost built"
@@ -0,0 +1,100 @@
+#!/bin/bash
+# Build the ZMC test corpus: CP/M 2.2 and CP/M 3 disk images with 16, 128,
+# 512 and 2048 directory entries (formats in ./diskdefs, with cpmtools or
+# without them with zmchost, see mkhost.sh).
+# usage: mkimages.sh [outdir]     (default: img)
+#
+# Every image B-<fmt>.img holds
+#   BIG.DAT       one file over many extents
+#   TEXT.TXT      8K text, 128 lines
+#   BIN.COM       4K binary, all byte values
+#   USERnn.TXT    one file in each user area 1..15 (as far as room)
+#   Fnnnn.DAT     one record files, up to 3/4 of the directory in use
+# and C-<fmt>.img is the empty destination. The content and the time
+# stamps (p3 formats) depend only on the format, the images are the same
+# on every run.
+
+cd "$(dirname "$0")" || exit 1 # cpmtools read ./diskdefs
+OUT=${1:-img}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+mkdir -p "$OUT"
+
+# no cpmtools: the same commands of zmchost
+if ! command -v mkfs.cpm > /dev/null; then
+    [ -x zmchost ] || ./mkhost.sh > /dev/null || exit 1
+    mkfs.cpm() { ./zmchost mkfs.cpm "$@"; }
+    cpmcp() { ./zmchost cpmcp "$@"; }
+fi
+
+# fixed time stamps, file n gets day n of 2026
+export TZ=UTC
+stamp() {
+    touch -t "$(date -d "2026-01-01 $2 days" +%Y%m%d)1200" "$1"
+}
+
+# file of $2 bytes repeating the line $3
+repeat() {
+    yes "$3" | head -c "$2" > "$1"
+}
+
+for FMT in zmc16 zmc128 zmc512 zmc2048; do
+    ENTRIES=${FMT#zmc}
+    case $ENTRIES in
+        16)   BIG=32 ;;
+        128)  BIG=128 ;;
+        512)  BIG=512 ;;
+        2048) BIG=1024 ;;
+    esac
+    # same files for both systems, on CP/M 3 every 4th entry holds the
+    # time stamps of the 3 entries before it
+    for OS in 2 3; do
+        NAME=$FMT
+        MKFS="mkfs.cpm -f $FMT"
+        USABLE=$ENTRIES
+        if [ $OS = 3 ]; then
+            NAME=${FMT}p3
+            MKFS="mkfs.cpm -f $NAME -t"
+            USABLE=$(( ENTRIES * 3 / 4 ))
+        fi
+        IMG=$OUT/B-$NAME.img
+        rm -f "$IMG" "$OUT/C-$NAME.img"
+        $MKFS "$IMG" > /dev/null || exit 1
+        $MKFS "$OUT/C-$NAME.img" > /dev/null || exit 1
+
+        repeat "$TMP/BIG.DAT" $(( BIG * 1024 )) "BIG.DAT $FMT record filler text......................."
+        stamp "$TMP/BIG.DAT" 1
+        awk 'BEGIN { for ( i = 1; i <= 128; ++i ) printf "%03d The quick brown fox jumps over the lazy dog. 0123456789\r\n", i }' \
+            | head -c 8192 > "$TMP/TEXT.TXT"
+        stamp "$TMP/TEXT.TXT" 2
+        for i in $(seq 0 255); do printf "\\$(printf %03o "$i")"; done > "$TMP/byte"
+        for i in $(seq 16); do cat "$TMP/byte"; done > "$TMP/BIN.COM"
+        stamp "$TMP/BIN.COM" 3
+        cpmcp -f $NAME -p "$IMG" "$TMP/BIG.DAT" "$TMP/TEXT.TXT" "$TMP/BIN.COM" 0: || exit 1
+        # BIG.DAT needs one entry per 16K (1K blocks) or 32K (4K blocks)
+        if [ $ENTRIES -le 128 ]; then USED=$(( BIG / 16 + 2 )); else USED=$(( BIG / 32 + 2 )); fi
+
+        USERS=$(( USABLE / 8 ))
+        [ $USERS -gt 15 ] && USERS=15
+        for u in $(seq $USERS); do
+            F=$(printf "USER%02d.TXT" "$u")
+            repeat "$TMP/$F" 1024 "user $u"
+            stamp "$TMP/$F" $(( 10 + u ))
+            cpmcp -f $NAME -p "$IMG" "$TMP/$F" $u: || exit 1
+            rm "$TMP/$F"
+        done
+        USED=$(( USED + USERS ))
+
+        FILL=$(( USABLE * 3 / 4 - USED ))
+        mkdir "$TMP/fill"
+        for n in $(seq 0 $(( FILL - 1 ))); do
+            F=$(printf "$TMP/fill/F%04d.DAT" "$n")
+            repeat "$F" 128 "$n"
+            stamp "$F" $(( 30 + n % 300 ))
+        done
+        # in one call, cpmcp opens the image once
+        [ $FILL -gt 0 ] && { cpmcp -f $NAME -p "$IMG" "$TMP"/fill/* 0: || exit 1; }
+        rm -rf "$TMP/fill" "$TMP"/*.*
+        echo "$IMG: $(( USED + FILL )) of $USABLE entries, $(( 3 + USERS + FILL )) files"
+    done
+done
@@ -0,0 +1,420 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// Directory cache: listings of drives kept in a compact form (the name
+// in FCB form with the attributes in its high bits, size, position and
+// date) in the unused end of the file storage of the panels, a panel
+// shows all the files it can hold, the cache gets what is left. A drive
+// change keeps the listing the panel leaves in the other panel, a cached
+// one is shown without a directory search. A slot is used only while
+// the allocation fingerprint of its drive (disk_print(), the free space
+// on CP/M 3) is the same as when it was read. A feature that needs the
+// storage of a panel calls dcache_claim(), the slots there move to the
+// other panel if they fit. CONFIG byte CACHE is the number of slots.
+// While ZMC waits for a key, dcache_idle() reads the recently used
+// drives that are not cached, load_window() stops at the next key.
+
+
+#define DC_SLOTS 8
+
+typedef struct {
+    uint8_t name[11]; // FCB form, F1' = tagged, T1'..T3' = R/O, SYS, ARC
+    uint16_t records;
+    uint16_t dirpos;
+    uint16_t date; // the rest only in listings with dates
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+} dc_entry;
+
+#define DC_UNDATED offsetof( dc_entry, date ) // without date and time
+
+typedef struct {
+    uint8_t *data; // num_files dc_entry in the tail of a panel
+    uint16_t size; // bytes at data
+    uint16_t num_files;
+    uint16_t print; // disk_print() when read
+    uint16_t used; // LRU stamp
+    char drive; // 0 = empty
+    uint8_t user;
+    uint8_t show_date;
+    uint8_t dated; // the entries have date and time
+    uint8_t tail; // in the storage of 0: the left, 1: the right panel
+} dir_slot;
+
+static dir_slot slots[DC_SLOTS];
+static uint8_t n_slots;
+static uint16_t stamp;
+static uint8_t lent[2]; // storage of the left/right panel used by a feature
+static char recent[16]; // drives shown, most recent first
+static uint8_t n_recent;
+
+
+// BIOS CONST: a key is waiting
+uint8_t key_ready( void ) {
+    return bios_direct( 2, 0, 0 ) != 0;
+}
+
+
+void dcache_init( void ) {
+    n_slots = *CACHE < DC_SLOTS ? *CACHE : DC_SLOTS;
+}
+
+
+static Panel *tail_panel( uint8_t t ) {
+    return t ? &App.right : &App.left;
+}
+
+
+// lowest byte of the slots in the storage of panel t, its end if none
+static uint8_t *tail_floor( uint8_t t ) {
+    uint8_t *lo = (uint8_t *)( tail_panel( t )->files + MAX_FILES );
+    uint8_t i;
+    for ( i = 0; i < n_slots; ++i )
+        if ( slots[i].drive && slots[i].tail == t && slots[i].data < lo )
+            lo = slots[i].data;
+    return lo;
+}
+
+
+// free bytes between the files of panel t and its slots
+static uint16_t tail_room( uint8_t t ) {
+    uint8_t *end = (uint8_t *)( tail_panel( t )->files + tail_panel( t )->num_files );
+    uint8_t *lo = tail_floor( t );
+    return lent[t] || lo < end ? 0 : lo - end;
+}
+
+
+// free slot s, the slots below it in the same storage move up
+static void slot_drop( dir_slot *s ) {
+    uint8_t *lo = tail_floor( s->tail );
+    uint8_t i;
+    memmove( lo + s->size, lo, s->data - lo );
+    for ( i = 0; i < n_slots; ++i )
+        if ( slots[i].drive && slots[i].tail == s->tail && slots[i].data < s->data )
+            slots[i].data += s->size;
+    s->drive = 0;
+}
+
+
+// an empty slot, else the least recently used one but spare is emptied
+static dir_slot *slot_free( dir_slot *spare ) {
+    dir_slot *lru = NULL;
+    uint8_t i;
+    for ( i = 0; i < n_slots; ++i ) {
+        if ( !slots[i].drive )
+            return &slots[i];
+        if ( &slots[i] != spare && ( !lru || slots[i].used < lru->used ) )
+            lru = &slots[i];
+    }
+    if ( lru )
+        slot_drop( lru );
+    return lru;
+}
+
+
+// size bytes below the slots in the storage of panel t, the least
+// recently used slots there but spare make room, NULL if that is not enough
+static uint8_t *slot_room( uint8_t t, uint16_t size, dir_slot *spare ) {
+    dir_slot *lru;
+    uint8_t i;
+    while ( tail_room( t ) < size ) {
+        if ( lent[t] )
+            return NULL;
+        for ( lru = NULL, i = 0; i < n_slots; ++i )
+            if ( slots[i].drive && slots[i].tail == t && &slots[i] != spare
+                && ( !lru || slots[i].used < lru->used ) )
+                lru = &slots[i];
+        if ( !lru )
+            return NULL;
+        slot_drop( lru );
+    }
+    return tail_floor( t ) - size;
+}
+
+
+// the storage of p (NULL: of both panels) is needed, the slots there move
+// to the other panel if they fit, until load_window() fills p again
+void dcache_claim( Panel *p ) {
+    dir_slot *s;
+    uint8_t i, t;
+
+    if ( !n_slots )
+        return;
+    if ( !p ) {
+        for ( i = 0; i < n_slots; ++i )
+            slots[i].drive = 0;
+        lent[0] = lent[1] = 1;
+        return;
+    }
+    if ( p != &App.left && p != &App.right ) // idle read, see dcache_idle()
+        return;
+    t = p == &App.right;
+    lent[t] = 1;
+    for ( i = 0, s = slots; i < n_slots; ++i, ++s ) {
+        if ( !s->drive || s->tail != t )
+            continue;
+        if ( tail_room( !t ) >= s->size ) {
+            memcpy( tail_floor( !t ) - s->size, s->data, s->size );
+            s->data = tail_floor( !t ) - s->size;
+            s->tail = !t;
+        } else
+            s->drive = 0;
+    }
+}
+
+
+// p holds a listing again, its free storage can take slots
+void dcache_loaded( Panel *p ) {
+    if ( p == &App.left || p == &App.right )
+        lent[p == &App.right] = 0;
+}
+
+
+// compact entry of f at d, d may overlap f if it is not above it
+static void dc_pack( uint8_t *d, const FileEntry *f, uint8_t dated ) {
+    FileEntry e;
+    dc_entry *c = (dc_entry *)d;
+    uint8_t bit;
+
+    memcpy( &e, f, sizeof( FileEntry ) );
+    name_to_fcb( c->name, e.cpmname );
+    for ( bit = 0; bit < 3; ++bit )
+        if ( e.attrib & ( 1 << bit ) )
+            c->name[8 + bit] |= 0x80;
+    if ( e.attrib & B_SEL )
+        c->name[0] |= 0x80;
+    c->records = e.extent;
+    c->dirpos = e.dirpos;
+    if ( dated )
+        memcpy( &c->date, &e.date, 6 ); // date, month, day, hour, minute
+}
+
+
+static void dc_unpack( FileEntry *f, const uint8_t *d, uint8_t dated ) {
+    const dc_entry *c = (const dc_entry *)d;
+    uint8_t bit;
+
+    memset( f, 0, sizeof( FileEntry ) );
+    dir_name( f->cpmname, c->name );
+    for ( bit = 0; bit < 3; ++bit )
+        if ( c->name[8 + bit] & 0x80 )
+            f->attrib |= 1 << bit;
+    if ( c->name[0] & 0x80 )
+        f->attrib |= B_SEL;
+    f->extent = c->records;
+    f->dirpos = c->dirpos;
+    if ( dated )
+        memcpy( &f->date, &c->date, 6 );
+}
+
+
+// any file of p with a date, the narrow panels do not show it
+static uint8_t has_dates( Panel *p ) {
+    uint16_t i;
+    for ( i = 0; i < p->num_files; ++i )
+        if ( p->files[i].date )
+            return 1;
+    return 0;
+}
+
+
+static uint8_t recent_rank( char drive ) {
+    uint8_t i;
+    for ( i = 0; i < n_recent && recent[i] != drive; ++i )
+        ;
+    return i;
+}
+
+
+static void recent_drop( char drive ) {
+    uint8_t i = recent_rank( drive );
+    if ( i < n_recent ) {
+        memmove( recent + i, recent + i + 1, n_recent - i - 1 );
+        --n_recent;
+    }
+}
+
+
+// drive was shown in a panel
+void dcache_used( char drive ) {
+    recent_drop( drive );
+    if ( n_recent == sizeof( recent ) )
+        --n_recent;
+    memmove( recent + 1, recent, n_recent++ );
+    *recent = drive;
+}
+
+
+static dir_slot *slot_of( char drive, uint8_t user ) {
+    uint8_t i;
+    for ( i = 0; i < n_slots; ++i )
+        if ( slots[i].drive == drive && slots[i].user == user )
+            return &slots[i];
+    return NULL;
+}
+
+
+// the listing of p is at d in the storage of panel t now
+static void slot_keep( dir_slot *s, Panel *p, uint8_t user, uint8_t t, uint8_t *d, uint8_t dated ) {
+    s->data = d;
+    s->size = p->num_files * ( dated ? sizeof( dc_entry ) : DC_UNDATED );
+    s->tail = t;
+    s->dated = dated;
+    s->drive = p->drive;
+    s->user = user;
+    s->num_files = p->num_files;
+    s->show_date = p->show_date;
+    s->print = disk_print( p->drive - 'A' );
+    s->used = ++stamp;
+}
+
+
+// keep the listing of p in the storage of panel t, spare stays cached
+static void slot_pack( Panel *p, uint8_t t, uint8_t user, dir_slot *spare ) {
+    dir_slot *s;
+    uint8_t *d;
+    uint16_t i;
+    uint8_t dated = has_dates( p );
+    uint8_t e = dated ? sizeof( dc_entry ) : DC_UNDATED;
+
+    if ( ( s = slot_of( p->drive, user ) ) ) // an older listing of the drive
+        slot_drop( s );
+    if ( !( s = slot_free( spare ) ) || !( d = slot_room( t, p->num_files * e, spare ) ) )
+        return;
+    for ( i = 0; i < p->num_files; ++i )
+        dc_pack( d + i * e, p->files + i, dated );
+    slot_keep( s, p, user, t, d, dated );
+}
+
+
+// the active panel changes to drive: its listing goes to the cache, a
+// cached listing of drive comes back, returns 0 if it must be read
+uint8_t dcache_switch( Panel *p, char drive ) {
+    dir_slot *hit;
+    uint16_t i;
+    uint8_t user, e, keep;
+    uint8_t t = p == &App.right;
+
+    // the same drive is read again, a FILTER is applied by load_window()
+    if ( !n_slots || drive == p->drive || *p->filter )
+        return 0;
+    user = bdos( 32, 0xFF ); // BDOS function 32 (F_USERNUM) - get user number
+    if ( ( hit = slot_of( drive, user ) ) && disk_print( drive - 'A' ) != hit->print ) {
+        slot_drop( hit ); // changed since
+        hit = NULL;
+    }
+    keep = p->mode == PM_DIR && p->total_files == p->num_files && !lent[t];
+    if ( hit ) { // the listing of drive fills the storage of p
+        dcache_claim( p );
+        if ( !hit->drive ) // no room in the other panel
+            hit = NULL;
+    }
+    if ( keep )
+        slot_pack( p, !t, user, hit );
+    if ( !hit )
+        return 0;
+    e = hit->dated ? sizeof( dc_entry ) : DC_UNDATED;
+    for ( i = 0; i < hit->num_files; ++i )
+        dc_unpack( p->files + i, hit->data + i * e, hit->dated );
+    p->drive = drive;
+    p->mode = PM_DIR;
+    p->num_files = p->total_files = hit->num_files;
+    p->win_base = 0;
+    p->show_date = hit->show_date;
+    p->current_idx = p->scroll_offset = 0;
+    slot_drop( hit ); // shown now, cached again when p leaves it
+    dcache_loaded( p );
+    sort_panel( p );
+    return 1;
+}
+
+
+// one step while no key is waiting: read the most recently used drive
+// that is neither shown nor cached, returns 0 if there is nothing to do
+uint8_t dcache_idle( void ) {
+    static Panel tmp;
+    dir_slot *s = NULL;
+    uint8_t *at;
+    uint16_t i, n;
+    uint8_t r, rank, worst, user, t, e, dated;
+    char drive;
+
+    if ( !n_slots )
+        return 0;
+    user = bdos( 32, 0xFF ); // BDOS function 32 (F_USERNUM) - get user number
+    for ( rank = 0; rank < n_recent; ++rank ) {
+        drive = recent[rank];
+        if ( drive != App.left.drive && drive != App.right.drive && !slot_of( drive, user ) )
+            break;
+    }
+    if ( rank == n_recent )
+        return 0;
+    // an empty slot, else the one of the least recently used drive
+    for ( worst = rank, i = 0; i < n_slots; ++i ) {
+        if ( !slots[i].drive ) {
+            s = &slots[i];
+            break;
+        }
+        if ( ( r = recent_rank( slots[i].drive ) ) > worst ) {
+            worst = r;
+            s = &slots[i];
+        }
+    }
+    if ( !s )
+        return 0;
+    if ( s->drive )
+        slot_drop( s );
+
+    // read into the larger free part, with its order after the entries
+    t = tail_room( 1 ) > tail_room( 0 );
+    n = tail_room( t ) / ( sizeof( FileEntry ) + sizeof( uint16_t ) );
+    if ( n < 16 )
+        return 0;
+    at = (uint8_t *)( tail_panel( t )->files + tail_panel( t )->num_files );
+    memset( &tmp, 0, sizeof( tmp ) );
+    tmp.files = (FileEntry *)at;
+    tmp.order = (uint16_t *)( tmp.files + n );
+    tmp.drive = drive;
+    load_idle = n;
+    r = load_window( &tmp, NULL, 0 );
+    load_idle = 0;
+    if ( r ) // a key, the next idle time starts again
+        return 0;
+    if ( tmp.total_files != tmp.num_files ) { // too large for the free storage
+        recent_drop( drive );
+        return 1;
+    }
+    // compact in place, then up to the other slots
+    dated = has_dates( &tmp );
+    e = dated ? sizeof( dc_entry ) : DC_UNDATED;
+    for ( i = 0; i < tmp.num_files; ++i )
+        dc_pack( at + i * e, tmp.files + i, dated );
+    n = tmp.num_files * e;
+    memmove( tail_floor( t ) - n, at, n );
+    slot_keep( s, &tmp, user, t, tail_floor( t ) - n, dated );
+    return 1;
+}
@@ -0,0 +1,648 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// MAP: the blocks of a disk from the DPB and the AL fields of the
+// directory, one character for a group of blocks: '.' free, ':' partly
+// used, '#' used, 'D' directory.
+// DEFRAG: a fragmented file is copied block by block to the first free
+// run that is long enough, then its directory entries get the new block
+// numbers. The old blocks stay as they are until the entries are
+// written, the changed directory sectors are written to the journal
+// $ZMC.JNL (with checksum) before. The next MAP of the drive completes
+// an interrupted DEFRAG from the journal, but only if the directory is
+// still as it was then.
+// The files are found in an index of the directory entries sorted by
+// user, name and extent, so their extents are next to each other.
+// The directory is read and written with the BIOS (diskcopy.c) into the
+// file storage of both panels, the panels are read again afterwards.
+
+
+#define JNL_SECS  8 // changed directory sectors of one file
+#define JNL_MAGIC 0x4A5A
+#define MAX_EXT   64 // directory entries of one file
+
+enum df_error { DF_MEMORY = 1, DF_SELECT, DF_JOURNAL, DF_IO, DF_RDONLY };
+enum jnl_state { JNL_NONE, JNL_DONE, JNL_STALE };
+
+typedef struct {
+    uint16_t magic; // JNL_MAGIC: the sectors are to be written
+    uint16_t sum; // of the sector bytes
+    uint8_t n; // sectors
+    uint8_t drive;
+    uint16_t size; // bytes per sector
+    uint16_t sec[JNL_SECS]; // directory sector numbers
+    uint16_t pre[JNL_SECS]; // sec_sum() of the sectors on the disk
+    uint16_t rest; // sec_sum() of all other directory sectors
+    uint16_t run; // the new blocks of the file
+    uint16_t len;
+} jnl_head;
+
+static uint8_t dpb[DPB_LEN];
+static uint8_t cpm3, drive, bsh, psh, exm, eshift;
+static uint8_t big; // 16 bit block numbers, 8 per entry
+static uint16_t xlt, dsm, entries, dir_secs, dir_blocks, off_trk;
+static uint8_t *used; // block bitmap
+static uint16_t *idx, n_idx; // file entries by user, name and extent
+static uint8_t *part[2]; // directory sectors in the panel storages
+static uint16_t part_secs; // sectors in part[0]
+static uint8_t jnl_fcb[36];
+static uint16_t ext[MAX_EXT]; // entries of the current file
+static uint8_t n_ext;
+static jnl_head hd;
+
+static const char *df_msg[] = { "", "NOT ENOUGH MEMORY", "CAN NOT SELECT THE DRIVE",
+    "CAN NOT WRITE $ZMC.JNL", "DISK ERROR", "DRIVE IS READ ONLY" };
+
+
+#define IS_USED(b) ( used[(b) >> 3] & ( 1 << ( (b) & 7 ) ) )
+#define SET_USED(b) ( used[(b) >> 3] |= 1 << ( (b) & 7 ) )
+#define SET_FREE(b) ( used[(b) >> 3] &= ~( 1 << ( (b) & 7 ) ) )
+
+
+static uint8_t *dir_sector( uint16_t s ) {
+    if ( s < part_secs )
+        return part[0] + ( s << ( psh + 7 ) );
+    return part[1] + ( ( s - part_secs ) << ( psh + 7 ) );
+}
+
+
+// entry i, 1 << eshift entries per sector
+static cpm_dir *dir_entry( uint16_t i ) {
+    return (cpm_dir *)( dir_sector( i >> eshift ) + ( ( i & ( ( 1 << eshift ) - 1 ) ) << 5 ) );
+}
+
+
+// physical sector ps of the data area: directory sector or block part
+static uint8_t data_io( uint8_t func, uint32_t ps, uint8_t *buf, uint8_t wtype ) {
+    return disk_sector( func, off_trk + ps / disk_nsec, ps % disk_nsec, buf, xlt, wtype );
+}
+
+
+static uint16_t al_get( cpm_dir *d, uint8_t k ) {
+    return big ? ( (uint16_t *)d->map )[k] : d->map[k];
+}
+
+
+static void al_set( cpm_dir *d, uint8_t k, uint16_t b ) {
+    if ( big )
+        ( (uint16_t *)d->map )[k] = b;
+    else
+        d->map[k] = b;
+}
+
+
+// the 11 name bytes are $ZMC.JNL (attributes ignored)
+static uint8_t is_jnl( const uint8_t *name ) {
+    static const char jnl_name[] = "$ZMC    JNL";
+    uint8_t k;
+    for ( k = 0; k < 11 && !( ( name[k] ^ jnl_name[k] ) & 0x7F ); ++k )
+        ;
+    return k == 11;
+}
+
+
+// order of the index: user, name without attributes, extent
+static int entryCompare( const void *a, const void *b ) {
+    cpm_dir *da = dir_entry( *(const uint16_t *)a );
+    cpm_dir *db = dir_entry( *(const uint16_t *)b );
+    uint16_t ea, eb;
+    uint8_t k;
+    if ( da->user != db->user )
+        return da->user < db->user ? -1 : 1;
+    for ( k = 0; k < 11; ++k )
+        if ( ( da->name[k] ^ db->name[k] ) & 0x7F )
+            return ( da->name[k] & 0x7F ) < ( db->name[k] & 0x7F ) ? -1 : 1;
+    ea = da->s2 * 32 + da->ex;
+    eb = db->s2 * 32 + db->ex;
+    return ea == eb ? 0 : ea < eb ? -1 : 1;
+}
+
+
+// the entries of the file at index position *pos to ext[], by extent
+// number, *pos moves to the next file. n_ext is 0 if the file has too
+// many entries. Returns 0 after the last file.
+static uint8_t next_file( uint16_t *pos ) {
+    cpm_dir *a, *b;
+    uint16_t n;
+    uint8_t k;
+
+    // not the journal, jnl_fcb holds its blocks
+    while ( *pos < n_idx && is_jnl( dir_entry( idx[*pos] )->name ) )
+        ++*pos;
+    if ( *pos >= n_idx )
+        return 0;
+    a = dir_entry( idx[*pos] );
+    for ( n = 0; *pos < n_idx; ++*pos, ++n ) {
+        b = dir_entry( idx[*pos] );
+        if ( b->user != a->user )
+            break;
+        for ( k = 0; k < 11 && !( ( a->name[k] ^ b->name[k] ) & 0x7F ); ++k )
+            ;
+        if ( k < 11 )
+            break;
+        if ( n < MAX_EXT )
+            ext[n] = idx[*pos];
+    }
+    n_ext = n <= MAX_EXT ? n : 0;
+    return 1;
+}
+
+
+// blocks of the file in next_file(), *frag: not in one run
+static uint16_t file_blocks( uint8_t *frag ) {
+    uint16_t n = 0, b, last = 0;
+    uint8_t e, k;
+    *frag = 0;
+    for ( e = 0; e < n_ext; ++e )
+        for ( k = 0; k < ( big ? 8 : 16 ); ++k )
+            if ( ( b = al_get( dir_entry( ext[e] ), k ) ) ) {
+                if ( n && b != last + 1 )
+                    *frag = 1;
+                last = b;
+                ++n;
+            }
+    return n;
+}
+
+
+// first free run of n blocks, *len the longest free run, 0 if none
+static uint16_t free_run( uint16_t n, uint16_t *len ) {
+    uint16_t b = dir_blocks, start = 0, run = 0;
+    *len = 0;
+    do {
+        if ( IS_USED( b ) )
+            run = 0;
+        else if ( !run++ )
+            start = b;
+        if ( run > *len )
+            *len = run;
+        if ( n && run == n )
+            return start;
+    } while ( b++ != dsm );
+    return 0;
+}
+
+
+// DPB of drive drv, bitmap and directory sectors in the panel storages
+static uint8_t df_memory( uint8_t drv ) {
+    uint16_t size = MAX_FILES * ( sizeof( FileEntry ) + sizeof( uint16_t ) );
+    uint16_t i, bm;
+
+    drive = drv;
+    cpm3 = disk_dpb( drv, dpb ) == DPB_LEN;
+    bsh = dpb[2];
+    exm = dpb[4];
+    dsm = *(uint16_t *)( dpb + 5 );
+    entries = *(uint16_t *)( dpb + 7 ) + 1;
+    off_trk = *(uint16_t *)( dpb + 13 );
+    psh = dpb[15];
+    eshift = psh + 2;
+    big = dsm > 255;
+    dir_secs = ( (uint32_t)entries * 32 + disk_sec_size - 1 ) / disk_sec_size;
+    // AL0, AL1: one bit for each directory block, from bit 7 of AL0
+    dir_blocks = 0;
+    for ( i = ( dpb[9] << 8 ) | dpb[10]; i & 0x8000; i <<= 1 )
+        ++dir_blocks;
+
+    // bitmap, index and directory in the storage of both panels
+    bm = ( dsm >> 3 ) + 1 + entries * sizeof( uint16_t );
+    dcache_claim( NULL );
+    used = (uint8_t *)App.left.files;
+    idx = (uint16_t *)( used + ( dsm >> 3 ) + 1 );
+    part[0] = used + bm;
+    part_secs = size > bm ? ( size - bm ) / disk_sec_size : 0;
+    part[1] = (uint8_t *)App.right.files;
+    if ( part_secs + size / disk_sec_size < dir_secs || disk_sec_size > XFER_RECS * 128 )
+        return DF_MEMORY;
+    return 0;
+}
+
+
+// the directory of drive drv, the bitmap of used blocks
+static uint8_t df_load( uint8_t drv ) {
+    uint16_t i, b;
+    uint8_t k, rc;
+    cpm_dir *d;
+
+    if ( ( rc = df_memory( drv ) ) )
+        return rc;
+
+    if ( ( xlt = disk_select( drv, 1 ) ) == 0xFFFF )
+        return DF_SELECT;
+    for ( i = 0; i < dir_secs; ++i )
+        if ( data_io( B_READ, i, dir_sector( i ), 0 ) )
+            return DF_IO;
+
+    memset( used, 0, ( dsm >> 3 ) + 1 );
+    for ( b = 0; b < dir_blocks; ++b )
+        SET_USED( b );
+    // the BDOS counts the blocks of all entries (CP/M 3: files only)
+    for ( i = 0; i < entries; ++i ) {
+        d = dir_entry( i );
+        if ( d->user == 0xE5 || ( cpm3 && d->user > 15 ) )
+            continue;
+        for ( k = 0; k < ( big ? 8 : 16 ); ++k )
+            if ( ( b = al_get( d, k ) ) && b <= dsm )
+                SET_USED( b );
+    }
+    // one sort instead of a search of the directory for each file
+    for ( n_idx = 0, i = 0; i < entries; ++i )
+        if ( dir_entry( i )->user < 16 )
+            idx[n_idx++] = i;
+    qsort( idx, n_idx, sizeof( uint16_t ), entryCompare );
+    return 0;
+}
+
+
+static void jnl_prepare( uint8_t drv ) {
+    memset( jnl_fcb, 0, sizeof( jnl_fcb ) );
+    jnl_fcb[0] = drv + 1;
+    memcpy( jnl_fcb + 1, "$ZMC    JNL", 11 );
+}
+
+
+// record r of the journal from or to buf
+static uint8_t jnl_io( uint8_t func, uint16_t r, uint8_t *buf ) {
+    uint8_t err;
+    bdos( 26, buf ); // BDOS function 26 (F_DMAOFF) - set DMA address
+    *(uint16_t *)( jnl_fcb + 33 ) = r;
+    jnl_fcb[35] = 0;
+    err = bdos( func, jnl_fcb ); // BDOS function 33/34 (F_READRAND/F_WRITERAND)
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    return err;
+}
+
+
+// sum of the sector bytes in the journal
+static uint16_t jnl_sum( jnl_head *h ) {
+    uint16_t sum = 0, j;
+    uint8_t k, *s;
+    for ( k = 0; k < h->n; ++k )
+        for ( s = dir_sector( h->sec[k] ), j = 0; j < h->size; ++j )
+            sum += s[j];
+    return sum;
+}
+
+
+// after the BIOS wrote the directory: the BDOS logs the drive in again
+static void df_reset( void ) {
+    bdos( 37, 1 << drive ); // BDOS function 37 (DRV_RESET) - reset drive
+    bdos( 13, 0 ); // BDOS function 13 (DRV_ALLRESET) - reset disk system
+}
+
+
+// sum of the entries of directory sector s without time stamps and
+// $ZMC.JNL, opening the journal may change them
+static uint16_t sec_sum( const uint8_t *s ) {
+    uint16_t sum = 0;
+    uint8_t e, k;
+    for ( e = 0; e < 1 << eshift; ++e, s += 32 ) {
+        if ( *s == 0x21 || is_jnl( s + 1 ) )
+            continue;
+        for ( k = 0; k < 32; ++k )
+            sum = ( sum << 1 | sum >> 15 ) + s[k]; // the position counts
+    }
+    return sum;
+}
+
+
+// sec_sum() of the whole directory
+static uint16_t dir_sum( void ) {
+    uint16_t sum = 0, i;
+    for ( i = 0; i < dir_secs; ++i )
+        sum += sec_sum( dir_sector( i ) );
+    return sum;
+}
+
+
+// the directory is as it was when the journal was written: the
+// journaled sectors as before or as in the journal (xfer_buf holds
+// sector k), the others the same, the new run of the file not used by
+// another entry. The journal sectors are checked against hd.sum.
+static uint8_t jnl_current( void ) {
+    uint16_t recs = hd.size / 128, sum = 0, rest = dir_sum(), r, i, b, cur;
+    uint8_t k, j, same = 1;
+    cpm_dir *d;
+
+    for ( k = 0; k < hd.n; ++k ) {
+        if ( hd.sec[k] >= dir_secs )
+            return 0;
+        for ( r = 0; r < recs; ++r )
+            jnl_io( 33, 1 + k * recs + r, xfer_buf + r * 128 ); // BDOS function 33 (F_READRAND)
+        for ( r = 0; r < hd.size; ++r )
+            sum += xfer_buf[r];
+        cur = sec_sum( dir_sector( hd.sec[k] ) );
+        rest -= cur;
+        if ( cur != hd.pre[k] && cur != sec_sum( xfer_buf ) )
+            same = 0;
+    }
+    if ( sum != hd.sum || !same || rest != hd.rest )
+        return 0;
+    for ( i = 0; i < entries; ++i ) {
+        for ( j = 0; j < hd.n && hd.sec[j] != i >> eshift; ++j )
+            ;
+        d = dir_entry( i );
+        if ( j < hd.n || d->user == 0xE5 || ( cpm3 && d->user > 15 ) )
+            continue;
+        for ( k = 0; k < ( big ? 8 : 16 ); ++k )
+            if ( ( b = al_get( d, k ) ) >= hd.run && b < hd.run + hd.len )
+                return 0;
+    }
+    return 1;
+}
+
+
+// complete an interrupted DEFRAG: write the sectors of a valid journal
+// if the directory did not change since (jnl_current()). The journal is
+// deleted, unless the directory can not be read.
+static uint8_t jnl_replay( uint8_t drv ) {
+    uint16_t r, recs;
+    uint8_t k, rc = JNL_NONE;
+
+    jnl_prepare( drv );
+    if ( bdos( 15, jnl_fcb ) == 255 ) // BDOS function 15 (F_OPEN) - open file
+        return JNL_NONE;
+    if ( !jnl_io( 33, 0, xfer_buf ) ) { // BDOS function 33 (F_READRAND)
+        memcpy( &hd, xfer_buf, sizeof( hd ) );
+        if ( hd.magic == JNL_MAGIC && hd.drive == drv && hd.size == disk_sec_size && hd.n <= JNL_SECS ) {
+            if ( df_load( drv ) ) // MAP shows the error
+                return JNL_NONE;
+            rc = JNL_STALE;
+            if ( jnl_current() ) {
+                // the sectors from the journal into the directory
+                recs = hd.size / 128;
+                for ( k = 0; k < hd.n; ++k )
+                    for ( r = 0; r < recs; ++r )
+                        jnl_io( 33, 1 + k * recs + r, dir_sector( hd.sec[k] ) + r * 128 ); // BDOS function 33 (F_READRAND)
+                if ( ( xlt = disk_select( drv, 1 ) ) != 0xFFFF ) {
+                    for ( k = 0; k < hd.n; ++k )
+                        data_io( B_WRITE, hd.sec[k], dir_sector( hd.sec[k] ), 1 );
+                    rc = JNL_DONE;
+                }
+            }
+        }
+    }
+    df_reset();
+    jnl_prepare( drv );
+    bdos( 19, jnl_fcb ); // BDOS function 19 (F_DELETE) - delete file
+    return rc;
+}
+
+
+// make the journal with all its records, so writing it later does
+// not allocate blocks
+static uint8_t jnl_create( uint8_t drv ) {
+    uint16_t r;
+    jnl_prepare( drv );
+    bdos( 19, jnl_fcb ); // BDOS function 19 (F_DELETE) - delete file
+    if ( bdos( 22, jnl_fcb ) == 255 ) // BDOS function 22 (F_MAKE) - create file
+        return DF_JOURNAL;
+    memset( xfer_buf, 0, 128 );
+    bdos( 26, xfer_buf ); // BDOS function 26 (F_DMAOFF) - set DMA address
+    for ( r = 0; r < 1 + JNL_SECS * ( disk_sec_size / 128 ); ++r )
+        if ( bdos( 21, jnl_fcb ) ) // BDOS function 21 (F_WRITE) - write next record
+            break;
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    bdos( 16, jnl_fcb ); // BDOS function 16 (F_CLOSE) - close file
+    if ( r < 1 + JNL_SECS * ( disk_sec_size / 128 ) ) {
+        bdos( 19, jnl_fcb ); // BDOS function 19 (F_DELETE) - delete file
+        return DF_JOURNAL;
+    }
+    return bdos( 15, jnl_fcb ) == 255 ? DF_JOURNAL : 0; // BDOS function 15 (F_OPEN) - open file
+}
+
+
+// write the n changed directory sectors secs, journal first
+static uint8_t dir_commit( uint8_t n, uint16_t *secs ) {
+    uint16_t recs = disk_sec_size / 128, r;
+    uint8_t k;
+
+    for ( k = 0; k < n; ++k )
+        for ( r = 0; r < recs; ++r )
+            if ( jnl_io( 34, 1 + k * recs + r, dir_sector( secs[k] ) + r * 128 ) ) // BDOS function 34 (F_WRITERAND)
+                return DF_JOURNAL;
+    hd.n = n;
+    hd.drive = drive;
+    hd.size = disk_sec_size;
+    memcpy( hd.sec, secs, n * sizeof( uint16_t ) );
+    hd.sum = jnl_sum( &hd );
+    hd.magic = JNL_MAGIC;
+    memset( xfer_buf, 0, 128 );
+    memcpy( xfer_buf, &hd, sizeof( hd ) );
+    if ( jnl_io( 34, 0, xfer_buf ) ) // BDOS function 34 (F_WRITERAND) - the commit
+        return DF_JOURNAL;
+    if ( cpm3 )
+        bdos( 48, 0 ); // BDOS function 48 (DRV_FLUSH) - write the buffers of the BDOS
+    for ( k = 0; k < n; ++k )
+        if ( data_io( B_WRITE, secs[k], dir_sector( secs[k] ), 1 ) )
+            return DF_IO;
+    memset( xfer_buf, 0, 128 );
+    jnl_io( 34, 0, xfer_buf ); // BDOS function 34 (F_WRITERAND) - done
+    if ( cpm3 )
+        bdos( 48, 0 ); // BDOS function 48 (DRV_FLUSH) - write the buffers of the BDOS
+    return 0;
+}
+
+
+// copy block from to block to through xfer_buf
+static uint8_t block_copy( uint16_t from, uint16_t to ) {
+    uint8_t spb = ( 1 << bsh ) >> psh; // sectors per block
+    uint8_t chunk = XFER_RECS * 128 / disk_sec_size;
+    uint8_t k, c, j;
+    for ( k = 0; k < spb; k += c ) {
+        c = spb - k < chunk ? spb - k : chunk;
+        for ( j = 0; j < c; ++j )
+            if ( data_io( B_READ, ( (uint32_t)from << bsh >> psh ) + k + j, xfer_buf + j * disk_sec_size, 0 ) )
+                return 1;
+        for ( j = 0; j < c; ++j )
+            if ( data_io( B_WRITE, ( (uint32_t)to << bsh >> psh ) + k + j, xfer_buf + j * disk_sec_size, 0 ) )
+                return 1;
+    }
+    return 0;
+}
+
+
+// move the fragmented files to free runs, *moved counts them
+static uint8_t defrag( uint16_t *moved, uint16_t *skipped ) {
+    uint16_t secs[JNL_SECS];
+    uint16_t pos, n, run, b, len, k, total;
+    uint8_t e, j, ns, frag, rc;
+    cpm_dir *d;
+
+    *moved = *skipped = 0;
+    if ( ( rc = jnl_create( drive ) ) || ( rc = df_load( drive ) ) ) // the journal blocks are used
+        return rc;
+    total = dir_sum();
+    for ( pos = 0; next_file( &pos ); ) {
+        if ( !n_ext || !( n = file_blocks( &frag ) ) || !frag )
+            continue;
+        // the directory sectors of the file, the journal holds JNL_SECS
+        for ( ns = 0, e = 0; e < n_ext && ns <= JNL_SECS; ++e ) {
+            k = ext[e] >> eshift;
+            for ( j = 0; j < ns && secs[j] != k; ++j )
+                ;
+            if ( j == ns && ns++ < JNL_SECS )
+                secs[j] = k;
+        }
+        if ( ns > JNL_SECS || !( run = free_run( n, &len ) ) ) {
+            ++*skipped;
+            continue;
+        }
+        dir_name( (char *)xfer_buf, dir_entry( *ext )->name );
+        show_progress( "DEFRAG", pos, n_idx, (char *)xfer_buf );
+        // the directory on the disk, for the replay
+        for ( hd.rest = total, k = 0; k < ns; ++k ) {
+            hd.pre[k] = sec_sum( dir_sector( secs[k] ) );
+            hd.rest -= hd.pre[k];
+        }
+        hd.run = run;
+        hd.len = n;
+        // copy the blocks, then the entries get the new numbers
+        for ( k = run, e = 0; e < n_ext; ++e ) {
+            d = dir_entry( ext[e] );
+            for ( j = 0; j < ( big ? 8 : 16 ); ++j )
+                if ( ( b = al_get( d, j ) ) ) {
+                    if ( block_copy( b, k ) )
+                        return DF_IO;
+                    al_set( d, j, k++ );
+                    SET_FREE( b );
+                }
+        }
+        for ( k = run; k < run + n; ++k )
+            SET_USED( k );
+        if ( ( rc = dir_commit( ns, secs ) ) )
+            return rc;
+        for ( total = hd.rest, k = 0; k < ns; ++k )
+            total += sec_sum( dir_sector( secs[k] ) );
+        ++*moved;
+    }
+    return 0;
+}
+
+
+// the map of the disk and its numbers
+static void map_show( void ) {
+    uint16_t cols = SCREEN_WIDTH - 1, rows = SCREEN_HEIGHT - 3;
+    uint16_t per, b, c, r, n, i, files = 0, frag_files = 0, nfree = 0, run;
+    uint8_t frag;
+
+    for ( i = 0; next_file( &i ); ++files )
+        if ( n_ext ) {
+            file_blocks( &frag );
+            frag_files += frag;
+        }
+    for ( b = 0; b <= dsm; ++b )
+        nfree += !IS_USED( b );
+    free_run( 0, &run );
+
+    clrscr();
+    set_invers();
+    printf( " MAP %c: %u BLOCKS OF %uK, %u FREE, LONGEST FREE RUN %u ",
+            'A' + drive, dsm + 1, 1 << ( bsh - 3 ), nfree, run );
+    set_normal();
+    printf( "\r\n" );
+    per = (uint16_t)( ( (uint32_t)dsm + cols * rows ) / ( cols * rows ) );
+    for ( b = 0, r = 0; r < rows && b <= dsm; ++r ) {
+        for ( c = 0; c < cols && b <= dsm; ++c ) {
+            for ( n = 0, i = 0; i < per && b + i <= dsm; ++i )
+                n += IS_USED( b + i ) != 0;
+            putchar( b < dir_blocks ? 'D' : !n ? '.' : n < i ? ':' : '#' );
+            b += per;
+        }
+        printf( "\r\n" );
+    }
+    gotoyx( SCREEN_HEIGHT - 1, 1 );
+    printf( " %u FILE(S), %u FRAGMENTED, %u BLOCK(S) PER CHARACTER", files, frag_files, per );
+    gotoyx( SCREEN_HEIGHT, 1 );
+    set_invers();
+    printf( " D: DEFRAG | <ESC>: EXIT " );
+    set_normal();
+}
+
+
+static void df_error( uint8_t rc ) {
+    gotoyx( SCREEN_HEIGHT, 1 );
+    erase_eol();
+    set_invers();
+    printf( " %s (<key>) ", df_msg[rc] );
+    set_normal();
+    wait_key_hw();
+}
+
+
+// MAP of the drive of panel p, D defragments it. Uses the storage of
+// both panels, they must be read again afterwards.
+void disk_map( Panel *p ) {
+    uint8_t drv = p->drive - 'A';
+    uint16_t moved, skipped;
+    uint8_t rc, k;
+
+    if ( ( rc = df_memory( drv ) ) ) {
+        df_error( rc );
+        return;
+    }
+    // CP/M 2.2 ends the program on a write to a R/O drive
+    if ( !( bdos_hl( 29, 0 ) & ( 1 << drv ) ) && ( rc = jnl_replay( drv ) ) ) { // BDOS function 29 (DRV_ROVEC) - R/O drives
+        gotoyx( SCREEN_HEIGHT, 1 );
+        erase_eol();
+        set_invers();
+        printf( rc == JNL_DONE ? " INTERRUPTED DEFRAG COMPLETED (<key>) "
+                               : " DISK CHANGED, OLD DEFRAG JOURNAL DISCARDED (<key>) " );
+        set_normal();
+        wait_key_hw();
+    }
+    for ( ;; ) {
+        if ( ( rc = df_load( drv ) ) ) {
+            df_error( rc );
+            return;
+        }
+        map_show();
+        k = wait_key_hw();
+        if ( ( k | 0x20 ) != 'd' )
+            return;
+        gotoyx( SCREEN_HEIGHT, 1 );
+        erase_eol();
+        if ( bdos_hl( 29, 0 ) & ( 1 << drv ) ) { // BDOS function 29 (DRV_ROVEC) - R/O drives
+            df_error( DF_RDONLY );
+            continue;
+        }
+        printf( " DEFRAG %c:? KEEP A BACKUP! (Y/N) ", p->drive );
+        if ( ( wait_key_hw() | 0x20 ) != 'y' )
+            continue;
+        rc = defrag( &moved, &skipped );
+        df_reset();
+        if ( rc ) { // the journal is left for the next MAP
+            df_error( rc );
+            return;
+        }
+        jnl_prepare( drv );
+        bdos( 19, jnl_fcb ); // BDOS function 19 (F_DELETE) - delete file
+        gotoyx( SCREEN_HEIGHT, 1 );
+        erase_eol();
+        printf( " %u FILE(S) MOVED, %u WITHOUT ROOM (<key>) ", moved, skipped );
+        wait_key_hw();
+    }
+}
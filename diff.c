@@ -0,0 +1,100 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// DIFF: compare the files under the cursor of both panels. Each file is
+// read in large blocks to the file storage of its panel, the drives
+// change once per block, a 64K file takes a few reads per side. Equal
+// blocks are done with one memcmp(), only a different block is compared
+// by record. The panels must be read again afterwards.
+
+
+long dump_at = 0; // DUMP starts at this offset, then 0 again
+
+
+// read up to max records with fcb to buf, left counts down
+static uint16_t diff_read( uint8_t *fcb, uint8_t *buf, uint16_t max, uint16_t *left ) {
+    uint16_t n;
+    for ( n = 0; n < max && *left; ++n, --*left ) {
+        bdos( 26, buf + n * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+        if ( bdos( 20, fcb ) ) // BDOS function 20 (F_READ) - read next record
+            break;
+    }
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    return n;
+}
+
+
+// compare the current files of a and b, returns the offset of the first
+// different byte and in recs the number of different records, -1 if the
+// files are the same, -2 if one can not be read (the panels are as
+// they were then)
+long diff_files( Panel *a, Panel *b, uint16_t *recs ) {
+    uint8_t *buf_a = (uint8_t *)a->files, *buf_b = (uint8_t *)b->files;
+    uint16_t block = MAX_FILES * ( sizeof( FileEntry ) + sizeof( uint16_t ) ) / 128;
+    uint16_t left_a, left_b, ext_a, ext_b, rec = 0, na, nb, n, r;
+    uint8_t i;
+    long first = -1;
+
+    *recs = 0;
+    if ( a->mode == PM_FIND || b->mode == PM_FIND || !a->num_files || !b->num_files || !block )
+        return -2;
+    // the entries are overwritten by the first block
+    ext_a = FILE_AT( a, a->current_idx ).extent;
+    ext_b = FILE_AT( b, b->current_idx ).extent;
+    // b first, its FCB and bounds move to fcb_dst, a keeps fcb_src
+    if ( open_src( b, &FILE_AT( b, b->current_idx ) ) == 255 )
+        return -2;
+    memcpy( fcb_dst, fcb_src, 36 );
+    left_b = src_recs;
+    if ( open_src( a, &FILE_AT( a, a->current_idx ) ) == 255 )
+        return -2;
+    left_a = src_recs;
+    dcache_claim( NULL );
+
+    do {
+        na = diff_read( fcb_src, buf_a, block, &left_a );
+        nb = diff_read( fcb_dst, buf_b, block, &left_b );
+        n = na < nb ? na : nb;
+        if ( memcmp( buf_a, buf_b, n * 128 ) ) {
+            for ( r = 0; r < n; ++r ) {
+                if ( !memcmp( buf_a + r * 128, buf_b + r * 128, 128 ) )
+                    continue;
+                if ( first < 0 ) {
+                    for ( i = 0; buf_a[r * 128 + i] == buf_b[r * 128 + i]; ++i )
+                        ;
+                    first = ( (long)( rec + r ) << 7 ) + i;
+                }
+                ++*recs;
+            }
+        }
+        rec += n;
+    } while ( na == block && nb == block );
+
+    if ( na != nb ) { // one file is longer, its other records differ too
+        if ( first < 0 )
+            first = (long)rec << 7;
+        *recs += ( ext_a > ext_b ? ext_a : ext_b ) - rec;
+    }
+    return first;
+}
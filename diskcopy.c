@@ -0,0 +1,220 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// DISKCOPY: exact image of a disk, system tracks, all user areas and
+// time stamps included. The tracks are read and written with the BIOS
+// (SELDSK, SETTRK, SETSEC, SETDMA, READ, WRITE), directly on CP/M 2.2,
+// with BDOS 50 on CP/M 3. Both disks must have the same DPB. The buffer
+// is the file storage of both panels, as many tracks per pass as fit,
+// the panels are read again afterwards.
+
+
+#define B_SELDSK  9
+#define B_SETTRK  10
+#define B_SETSEC  11
+#define B_SETDMA  12
+#define B_SECTRAN 16
+#define B_SETBNK  28 // CP/M 3: bank of the DMA buffer
+
+
+typedef struct {
+    uint8_t func;
+    uint8_t a;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+} bios_pb; // BDOS 50 parameter block
+
+static bios_pb pb;
+static uint8_t cpm3;
+
+uint16_t disk_nsec; // physical sectors per track
+uint16_t disk_sec_size; // bytes per physical sector
+
+static uint16_t xlt_src, xlt_dst; // sector translation tables
+static uint8_t *region[2]; // the panel storages
+static uint16_t region_trk[2]; // tracks in each
+static uint16_t tracks; // of the disk
+static char drv[3] = "A:"; // for the progress line
+static uint16_t io_trk; // the track being read or written
+
+
+static uint16_t bios_call( uint8_t func, uint8_t a, uint16_t bc, uint16_t de ) {
+    if ( !cpm3 )
+        return bios_direct( func, bc, de );
+    pb.func = func;
+    pb.a = a;
+    pb.bc = bc;
+    pb.de = de;
+    if ( func == B_SELDSK || func == B_SECTRAN )
+        return bdos_hl( 50, (uint16_t)&pb ); // BDOS function 50 (S_BIOS) - direct BIOS call
+    return bdos( 50, &pb ); // BDOS function 50 (S_BIOS) - direct BIOS call
+}
+
+
+// BIOS disk access, also used by DEFRAG: the DPB of drive drv (DPB_LEN
+// bytes) and the geometry, with first the BDOS logs the drive in.
+// Returns the DPB length (15 CP/M 2.2, 17 CP/M 3)
+uint8_t disk_dpb( uint8_t drv, uint8_t *dpb ) {
+    uint8_t len;
+    cpm3 = bdos( 12, NULL ) >= 0x30;
+    len = cpm3 ? DPB_LEN : 15;
+    bdos( 14, drv ); // BDOS function 14 (DRV_SET) - select disk
+    memcpy( dpb, (uint8_t *)bdos_hl( 31, 0 ), len ); // BDOS function 31 (DRV_DPB) - get DPB address
+    if ( !cpm3 )
+        dpb[15] = dpb[16] = 0; // 128 byte sectors
+    disk_sec_size = 128 << dpb[15];
+    disk_nsec = *(uint16_t *)dpb >> dpb[15];
+    return len;
+}
+
+
+// select drive for the BIOS, returns the XLT address, 0xFFFF on error
+uint16_t disk_select( uint8_t drv, uint8_t first ) {
+    uint16_t dph;
+    if ( cpm3 && first )
+        bdos( 48, 0 ); // BDOS function 48 (DRV_FLUSH) - write the buffers of the BDOS
+    dph = bios_call( B_SELDSK, 0, drv, first ? 0 : 1 );
+    return dph ? *(uint16_t *)dph : 0xFFFF;
+}
+
+
+// read (B_READ) or write (B_WRITE) physical sector sec of track trk,
+// wtype 1 (directory write) makes a deblocking BIOS write at once
+uint8_t disk_sector( uint8_t func, uint16_t trk, uint16_t sec, uint8_t *buf,
+                     uint16_t xlt, uint8_t wtype ) {
+    bios_call( B_SETTRK, 0, trk, 0 );
+    bios_call( B_SETSEC, 0, bios_call( B_SECTRAN, 0, sec, xlt ), 0 );
+    bios_call( B_SETDMA, 0, (uint16_t)buf, 0 );
+    if ( cpm3 )
+        bios_call( B_SETBNK, 1, 0, 0 ); // TPA bank
+    return bios_call( func, 0, wtype, 0 );
+}
+
+
+// read (B_READ) or write (B_WRITE) n tracks from track trk at buf,
+// returns 0 or the BIOS error
+static uint8_t track_io( uint8_t func, uint16_t trk, uint16_t n, uint8_t *buf, uint16_t xlt ) {
+    uint16_t s;
+    for ( ; n; --n, ++trk ) {
+        io_trk = trk;
+        show_progress( func == B_READ ? "READ" : "WRITE", trk + 1, tracks, drv );
+        for ( s = 0; s < disk_nsec; ++s, buf += disk_sec_size )
+            // the last sector of a track as directory write: the host
+            // buffer of a deblocking BIOS is written
+            if ( disk_sector( func, trk, s, buf, xlt, s == disk_nsec - 1 ) )
+                return 1;
+    }
+    return 0;
+}
+
+
+// read the n tracks at trk again sector by sector to xfer_buf,
+// returns 1 if they are the same as buf
+static uint8_t track_verify( uint16_t trk, uint16_t n, uint8_t *buf ) {
+    uint16_t s;
+    for ( ; n; --n, ++trk ) {
+        io_trk = trk;
+        show_progress( "VERIFY", trk + 1, tracks, drv );
+        for ( s = 0; s < disk_nsec; ++s, buf += disk_sec_size )
+            if ( disk_sector( B_READ, trk, s, xfer_buf, xlt_dst, 0 )
+                 || memcmp( xfer_buf, buf, disk_sec_size ) )
+                return 0;
+    }
+    return 1;
+}
+
+
+// copy drive src to drive dst (0 = A:)
+static int copy_tracks( uint8_t src, uint8_t dst, uint8_t verify ) {
+    uint8_t dpb[2 * DPB_LEN]; // dst, src
+    uint16_t spt, t, n, i, m;
+    uint32_t recs;
+    uint8_t r, len;
+
+    io_trk = 0;
+    // the DPB of both drives, logged in by the BDOS
+    len = disk_dpb( dst, dpb );
+    if ( disk_dpb( src, dpb + DPB_LEN ) != len || memcmp( dpb, dpb + DPB_LEN, len ) )
+        return DC_FORMAT;
+
+    spt = *(uint16_t *)dpb; // 128 byte records per track
+    // reserved tracks + data tracks, blocks of 128 << BSH bytes
+    recs = (uint32_t)( *(uint16_t *)( dpb + 5 ) + 1 ) << dpb[2];
+    tracks = *(uint16_t *)( dpb + 13 ) + ( recs + spt - 1 ) / spt;
+    if ( disk_sec_size > XFER_RECS * 128 ) // verify buffer
+        return DC_MEMORY;
+
+    dcache_claim( NULL );
+    region[0] = (uint8_t *)App.left.files;
+    region[1] = (uint8_t *)App.right.files;
+    for ( r = 0; r < 2; ++r )
+        region_trk[r] = MAX_FILES * ( sizeof( FileEntry ) + sizeof( uint16_t ) ) / 128 / spt;
+    if ( !region_trk[0] )
+        return DC_MEMORY;
+
+    xlt_src = disk_select( src, 1 );
+    xlt_dst = disk_select( dst, 1 );
+    if ( xlt_src == 0xFFFF || xlt_dst == 0xFFFF )
+        return DC_SELECT;
+
+    for ( t = 0; t < tracks; t += n ) {
+        // read as many tracks as fit into both regions, then write them
+        drv[0] = 'A' + src;
+        disk_select( src, 0 );
+        for ( n = 0, r = 0; r < 2 && t + n < tracks; ++r ) {
+            m = region_trk[r] < tracks - t - n ? region_trk[r] : tracks - t - n;
+            if ( track_io( B_READ, t + n, m, region[r], xlt_src ) )
+                return DC_READ;
+            n += m;
+        }
+        drv[0] = 'A' + dst;
+        disk_select( dst, 0 );
+        for ( i = 0, r = 0; i < n; ++r, i += m ) {
+            m = region_trk[r] < n - i ? region_trk[r] : n - i;
+            if ( track_io( B_WRITE, t + i, m, region[r], xlt_dst ) )
+                return DC_WRITE;
+            if ( verify && !track_verify( t + i, m, region[r] ) )
+                return DC_VERIFY;
+        }
+    }
+    return 0;
+}
+
+
+// copy drive src to drive dst (0 = A:) track by track, returns 0 or
+// DC_..., *trk is the track of a read, write or verify error
+int disk_copy( uint8_t src, uint8_t dst, uint8_t verify, uint16_t *trk ) {
+    int rc = copy_tracks( src, dst, verify );
+    *trk = io_trk;
+    return rc;
+}
+
+
+// after disk_copy(): the BDOS forgets the target disk, the disk system
+// reset selects A: through the BIOS again, so BIOS and BDOS agree
+void disk_copy_done( uint8_t dst ) {
+    bdos( 37, 1 << dst ); // BDOS function 37 (DRV_RESET) - reset drive
+    bdos( 13, 0 ); // BDOS function 13 (DRV_ALLRESET) - reset disk system
+}
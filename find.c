@@ -0,0 +1,145 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// FIND: the BDOS matches the pattern on every logged in drive, only the
+// hits are stored in the panel, in the order they are found (by drive).
+// A hit keeps drive and user in dirpos, see HIT_DRIVE() and HIT_USER().
+
+
+// add the directory entry d named name of drive drv, returns the entry or
+// NULL if full
+static FileEntry *find_hit( Panel *p, uint16_t first, uint8_t drv, cpm_dir *d, const char *name ) {
+    uint16_t key = ( drv << 8 ) | d->user;
+    FileEntry *f = p->files + first;
+    FileEntry *end = p->files + p->num_files;
+
+    // another extent of a file found before on this drive?
+    while ( f < end && ( f->dirpos != key || name_cmp( f->cpmname, name ) ) )
+        ++f;
+    if ( f == end ) { // new file
+        if ( p->num_files == MAX_FILES )
+            return NULL;
+        memset( f, 0, sizeof( FileEntry ) );
+        strcpy( f->cpmname, name );
+        for ( uint8_t bit = 0; bit < 3; ++bit )
+            if ( d->type[bit] > 0x7F )
+                f->attrib |= 1 << bit;
+        f->dirpos = key;
+        p->order[p->num_files] = p->num_files;
+        ++p->num_files;
+    }
+    return f;
+}
+
+
+// search pattern "NAME.EXT" with wildcards on all logged in drives,
+// all_users: search all user areas, not only the current one
+void find_files( Panel *p, const char *pattern, uint8_t all_users ) {
+    uint16_t login = bdos_hl( 24, 0 ); // BDOS function 24 (DRV_LOGINVEC) - logged in drives
+    uint8_t x = ( p == &App.left ) ? 1 : PANEL_WIDTH + 1;
+    uint8_t user = bdos( 32, 0xFF ); // BDOS function 32 (F_USERNUM) - get user number
+    char name[FILENAME_LEN];
+    uint8_t drv, exm, result;
+
+    dcache_claim( p );
+    p->mode = PM_FIND;
+    strncpy( p->pattern, pattern, FILENAME_LEN - 1 );
+    p->pattern[FILENAME_LEN - 1] = '\0';
+    p->num_files = 0;
+    p->total_files = 0;
+    p->win_base = 0;
+    p->current_idx = 0;
+    p->scroll_offset = 0;
+    p->show_date = 0;
+    draw_panel( p, x ); // empty panel, the hits are drawn as they arrive
+
+    for ( drv = 0; drv < 16; ++drv ) {
+        uint16_t first = p->num_files; // hits of this drive start here
+        if ( !( login & ( 1 << drv ) ) )
+            continue;
+        bdos( 14, drv ); // BDOS function 14 (DRV_SET) - select disk
+        exm = ((uint8_t *)bdos_hl( 31, 0 ))[4]; // BDOS function 31 (DRV_DPB) - get DPB address
+
+        // '?' as drive searches the default drive, all user numbers, but
+        // it matches every entry, the name is compared here then
+        memset( fcb_src, 0, 36 );
+        fcb_src[0] = all_users ? '?' : 0;
+        name_to_fcb( fcb_src+1, pattern );
+        memset( &fcb_src[12], '?', 4 ); // all extents
+        result = bdos( 17, fcb_src ); // BDOS function 17 (F_SFIRST) - search for first
+        while ( result != 255 ) {
+            cpm_dir *d = (cpm_dir *)( 0x80 + ( result * 32 ) );
+            dir_name( name, d->name );
+            // no erased entries, labels, time stamps or passwords
+            if ( d->user < 16 && ( all_users ? match_name( fcb_src+1, name ) : d->user == user ) ) {
+                FileEntry *f = find_hit( p, first, drv, d, name );
+                uint16_t recs = ( ( (uint16_t)( d->s2 ) * 32 + d->ex ) << 7 ) + d->rc;
+                if ( f == NULL )
+                    break; // panel full
+                if ( recs > f->extent )
+                    f->extent = recs;
+                // the CP/M 3 date of the 1st extent
+                if ( d->s2 == 0 && d->ex <= exm && result < 3 && *((uint8_t *)(0xE0)) == '!' ) {
+                    date_time_dir *dtd = (date_time_dir *)(0xE0);
+                    f->date = dtd->dt[result].update.date;
+                    f->hour = dtd->dt[result].update.hour;
+                    f->minute = dtd->dt[result].update.minute;
+                    days_to_date( &(f->date) );
+                }
+                draw_file_line( p, x, f - p->files );
+            }
+            result = bdos( 18, fcb_src ); // BDOS function 18 (F_SNEXT) - search for next
+        }
+        if ( p->num_files == MAX_FILES )
+            break;
+    }
+    p->total_files = p->num_files;
+    sort_panel( p );
+}
+
+
+// leave the FIND result: show the directory of the file under the cursor,
+// returns 1 if the user number was changed
+uint8_t find_jump( Panel *p ) {
+    char name[FILENAME_LEN];
+    FileEntry *f;
+    uint8_t user;
+
+    if ( p->mode != PM_FIND || !p->num_files )
+        return 0;
+    f = &FILE_AT( p, p->current_idx );
+    strcpy( name, f->cpmname );
+    p->drive = 'A' + HIT_DRIVE( f );
+    user = HIT_USER( f );
+    if ( user != bdos( 32, 0xFF ) ) // BDOS function 32 (F_USERNUM) - get user number
+        bdos( 32, user ); // BDOS function 32 (F_USERNUM) - set user number
+    else
+        user = 0xFF;
+
+    *p->filter = '\0'; // the file may not match the filter
+    load_directory( p );
+    goto_file( p, name );
+    return user != 0xFF;
+}
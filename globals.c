@@ -6,9 +6,33 @@
 AppState App;
 
 
+#ifdef FIXED_COLS
+uint8_t CONFIG[] = { // fixed geometry, only for --CONFIG
+    FIXED_COLS,
+    FIXED_LINES,
+#else
 uint8_t CONFIG[] = { // 80x40
     80,  // Columns
-    32   // Lines
+    32,  // Lines
+#endif
+    TERM_ANSI, // Terminal profile, index into TERMS
+    4 // directory cache slots, in the free panel storage, 0 = off
+};
+
+
+// Terminal profiles, patchable like CONFIG (TERM_CUSTOM is free for the user).
+// Cursor addressing is either ANSI "ESC [ row ; col H" or binary:
+// lead-in, row + offset, col + offset (row and col zero based).
+term_profile TERMS[TERM_TYPES] = {
+    // cup,   offset, lead,    eeol,     cls,           inv,         norm,        con,          coff
+    // ANSI / VT100
+    { CUP_ANSI, 0,    "",      "\x1b[K", "\x1b[H\x1b[J", "\x1b[7m",    "\x1b[m",     "\x1b[?25h",  "\x1b[?25l" },
+    // VT52 with H19 extensions
+    { CUP_BIN,  0x20, "\x1bY", "\x1bK",  "\x1bH\x1bJ",   "\x1bp",      "\x1bq",      "\x1by5",     "\x1bx5" },
+    // ADM-3A / Kaypro
+    { CUP_BIN,  0x20, "\x1b=", "\x18",   "\x1a",         "\x1b" "B0", "\x1b" "C0", "\x1b" "B4", "\x1b" "C4" },
+    // custom, default ANSI
+    { CUP_ANSI, 0,    "",      "\x1b[K", "\x1b[H\x1b[J", "\x1b[7m",    "\x1b[m",     "\x1b[?25h",  "\x1b[?25l" }
 };
 
 
@@ -16,35 +40,130 @@ char cmdline[CMDLINELEN+1];
 
 uint8_t DEBUG = 0;
 uint8_t DEVEL = 0;
+uint8_t PROFILE = 0;
+uint8_t BATCH = 0;
+
+uint8_t home_drive = 0;
 
-const uint8_t *COLUMNS = CONFIG;
-const uint8_t *LINES = CONFIG+1;
+uint8_t *COLUMNS = CONFIG;
+uint8_t *LINES = CONFIG+1;
+uint8_t *TERM = CONFIG+2;
+uint8_t *CACHE = CONFIG+3;
 
 uint16_t MAX_FILES = 0;
 
 
+// cursor position after the last gotoyx(), cursor_moved() tells
+// how far the output went since then, only then relative moves are used
+static uint8_t cur_row = 0;
+static uint8_t cur_col = 0;
+static uint8_t cur_valid = 0;
+
+
+static void term_puts( const char *s ) {
+    while ( *s )
+        putchar( *s++ );
+}
+
+
+// position the cursor (1,1 = top left) with the shortest sequence
+void gotoyx( uint8_t row, uint8_t col ) {
+    term_profile *t = &TERMS[*TERM];
+
+    if ( cur_valid && row == cur_row && col == cur_col )
+        ; // already there
+    else if ( cur_valid && row == cur_row && col == 1 )
+        putchar( CR );
+    else if ( cur_valid && row == cur_row + 1 && col == 1 ) {
+        putchar( CR );
+        putchar( LF );
+    } else if ( cur_valid && row == cur_row + 1 && col == cur_col )
+        putchar( LF );
+    else if ( t->cup == CUP_BIN ) { // 4 byte for VT52 and ADM-3A
+        term_puts( t->lead );
+        putchar( row - 1 + t->offset );
+        putchar( col - 1 + t->offset );
+    } else { // ANSI, row and col 1 are default
+        putchar( ESC );
+        putchar( '[' );
+        if ( cur_valid && row == cur_row && col > cur_col )
+            printf( "%dC", col - cur_col ); // cursor forward
+        else {
+            if ( row > 1 )
+                printf( "%d", row );
+            if ( col > 1 )
+                printf( ";%d", col );
+            putchar( 'H' );
+        }
+    }
+    cur_row = row;
+    cur_col = col;
+    cur_valid = 0;
+}
+
+
+// exactly n characters were printed since the last gotoyx()
+void cursor_moved( uint8_t n ) {
+    cur_col += n;
+    // at the right margin the terminal may wrap
+    cur_valid = cur_col <= SCREEN_WIDTH;
+}
+
+
+// erase to end of line, call directly after gotoyx()
+void erase_eol() {
+    const char *s = TERMS[*TERM].eeol;
+    if ( *s )
+        term_puts( s );
+    else { // no erase function, overwrite with spaces
+        uint8_t n = SCREEN_WIDTH - cur_col;
+        while ( n-- )
+            putchar( SPC );
+        gotoyx( cur_row, cur_col );
+    }
+}
+
+
+// CR and erase the current line, used by the scrolling viewer
+void erase_line() {
+    const char *s = TERMS[*TERM].eeol;
+    putchar( CR );
+    if ( *s )
+        term_puts( s );
+    else {
+        uint8_t n = SCREEN_WIDTH - 1;
+        while ( n-- )
+            putchar( SPC );
+        putchar( CR );
+    }
+}
+
+
 void show_cursor() {
-    printf("\x1b[?25h");
+    term_puts( TERMS[*TERM].con );
 }
 
 
 void hide_cursor() {
-    printf("\x1b[?25l");
+    term_puts( TERMS[*TERM].coff );
 }
 
 
 void set_invers() {
-    printf("\x1b[7m");
+    term_puts( TERMS[*TERM].inv );
 }
 
 
 void set_normal() {
-    printf("\x1b[0m");
+    term_puts( TERMS[*TERM].norm );
 }
 
 
+// clear screen, home and hide cursor
 void clrscr() {
-    printf("\x1b[2J\x1b[?25l");
+    term_puts( TERMS[*TERM].cls );
+    hide_cursor();
+    cur_valid = 0;
 }
 
 void print_cpm_attrib( uint8_t *ca) {
@@ -58,8 +177,11 @@ void print_cpm_attrib( uint8_t *ca) {
 
 
 void show_prompt() {
-    printf("\x1b[%d;1H\x1b[0m%c> %s\x1b[?25h\x1b[K",
-           PANEL_HEIGHT+1, App.active_panel->drive, cmdline );
+    gotoyx( PANEL_HEIGHT+1, 1 );
+    set_normal();
+    erase_eol(); // directly after gotoyx(), see there
+    printf( "%c> %s", App.active_panel->drive, cmdline );
+    show_cursor();
 }
 
 
@@ -68,20 +190,24 @@ void refresh_ui(uint8_t which_panel) {
         if ( App.left.active )
             draw_panel(&App.left, 1);
         else if ( App.right.active )
-            draw_panel(&App.right, *COLUMNS/2+1);
+            draw_panel(&App.right, PANEL_WIDTH+1);
     }
     if ( which_panel & 0b10) {
-        if ( App.right.active )
+        if ( qview ) // the other panel shows the current file
+            qview_draw();
+        else if ( App.right.active )
             draw_panel(&App.left, 1);
         else if ( App.left.active )
-            draw_panel(&App.right, *COLUMNS/2+1);
+            draw_panel(&App.right, PANEL_WIDTH+1);
+    }
+    if ( PANEL_WIDTH >= 30 ) {
+        gotoyx( PANEL_HEIGHT+2, 1 );
+        set_invers();
+        if ( PANEL_WIDTH >= 40 )
+            printf("| A: - P: | TAB:Sw | F1:Help | F3:View | F4:Dump | F5:Copy | F8:Del | F10:Exit |");
+        else
+            printf("A:-P:|TAB:Sw|F1:Help|F3:View|F4:Dump|F5:Copy|F8:Del|F10:Exit");
+        set_normal();
     }
-    if ( PANEL_WIDTH >= 40 )
-        printf("\x1b[%d;1H\x1b[7m| A: - P: | TAB:Sw | F1:Help | F3:View | F4:Dump | F5:Copy | F8:Del | F10:Exit |\x1b[0m", PANEL_HEIGHT+2);
-    else if ( PANEL_WIDTH >= 30 )
-        printf("\x1b[%d;1H\x1b[7mA:-P:|TAB:Sw|F1:Help|F3:View|F4:Dump|F5:Copy|F8:Del|F10:Exit\x1b[0m", PANEL_HEIGHT+2);
     show_prompt();
 }
-
-
-
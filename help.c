@@ -0,0 +1,118 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+
+#include "zmc.h"
+
+
+#ifdef OVL_MODULE
+// overlay entry point, must be the first function of the overlay
+int ovl_main( uint8_t fn, void *arg ) {
+    if ( fn == 0 )
+        help();
+    else if ( fn == 1 )
+        key_test();
+    else if ( fn == 2 )
+        show_config();
+    return 0;
+}
+#endif
+
+
+static void help_line( uint8_t line, const char *keys, const char *text ) {
+    gotoyx( line, 1 );
+    printf( "%s", keys );
+    gotoyx( line, 32 );
+    printf( "%s", text );
+}
+
+
+void help() {
+    set_normal();
+    clrscr(); // cls, home, hide cursor
+    puts( " #######  #     #   #####  " );
+    puts( "      #   ##   ##  #     # " );
+    puts( "     #    # # # #  #       " );
+    puts( "    #     #  #  #  #       " );
+    puts( "   #      #     #  #       " );
+    puts( "  #       #     #  #     # " );
+    puts( " #######  #     #   #####  " );
+    puts( "                           " );
+    puts( " ZMC v1.2 - Volney Torres " );
+
+    // 14 lines from line 10, the list fits 24 line screens
+    uint8_t line = 10;
+    help_line( line++, "A: ... P:, [TAB]", "Select drive, change panel" );
+    help_line( line++, "[F2], SORT [N|E|S|D|U]", "Sort by name/ext/size/date/unsorted" );
+    help_line( line++, "FILTER [pattern]", "Show matching files only" );
+    help_line( line++, "[F3] TYPE, [F4] DUMP", "Show file (unpack .?Q? .?Z?), hex, E: patch" );
+    help_line( line++, "[F5], COPY, CP [d: d: ...]", "Copy file(s) [to several drives]" );
+    help_line( line++, "[F6], QV", "Quick view in the other panel" );
+    help_line( line++, "[F7], FIND [pattern] [/U]", "Find on all drives [users]" );
+    help_line( line++, "[F8], DEL, ERA, RM", "Delete file(s)" );
+    help_line( line++, "COMPARE / SYNC", "Tag / copy new and changed files" );
+    help_line( line++, "DIFF, FC", "Compare files at the cursors" );
+    help_line( line++, "DISKCOPY [/V] / MAP", "Copy disk [verify] / block map, D: defrag" );
+    help_line( line++, "[ENTER] on .LBR, [BS]", "Open library, back to disk" );
+    help_line( line++, "!command", "Run CP/M command, come back" );
+    help_line( line++, "[F9], [ESC][ESC], QUIT, EXIT", "Exit" );
+    wait_key_hw();
+    refresh_ui( PAN_BOTH );
+}
+
+
+// test for terminal function keys, exit with <ESC><ESC>
+void key_test() {
+    uint8_t k;
+    uint8_t esc = 0;
+    for(;;) {
+        k = wait_key_hw();
+        printf( "0x%02X  ", k );
+        if ( k == ESC )
+            puts( "ESC" );
+        else if (k < ESC )
+            printf( "^%c\n", k + '@');
+        else    // show printable chars, else '.'
+            printf( "%c\n", k >= ' ' && k < 128 ? k : '.' );
+        if ( esc && k == ESC ) // <ESC><ESC>
+            return;
+        esc = k == ESC; // remember <ESC>
+    }
+}
+
+
+// show address of screen size constants in zmc.com
+void show_config() {
+#ifdef FIXED_COLS
+    printf( "COLUMNS: %d, LINES: %d (fixed)\n", SCREEN_WIDTH, SCREEN_HEIGHT );
+#else
+    printf( "COLUMNS @ 0x%04X: %d\n", COLUMNS - 0x100, *COLUMNS );
+    printf( "LINES @ 0x%04X: %d\n", LINES - 0x100, *LINES );
+#endif
+    printf( "TERM @ 0x%04X: %d (0 ANSI, 1 VT52/H19, 2 ADM-3A/Kaypro, 3 custom)\n",
+            TERM - 0x100, *TERM );
+    printf( "CACHE @ 0x%04X: %d (cached drive listings, 0 = off)\n",
+            CACHE - 0x100, *CACHE );
+    printf( "TERMS @ 0x%04X: %u bytes per profile\n",
+            (uint8_t *)TERMS - 0x100, sizeof( term_profile ) );
+    printf( "MAX_FILES: %u\n", MAX_FILES );
+#ifdef OVERLAYS
+    ovl_info();
+#endif
+}
@@ -0,0 +1,356 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <string.h>
+
+#include "zmc.h"
+
+
+// Inner loops that run per directory entry or per byte of a file.
+// Z80 assembler by default, the C versions are built with -DNOASM.
+// sccz80 pushes the arguments left to right: the last one is at (sp+2).
+
+
+const char hex_digits[] = "0123456789ABCDEF";
+
+
+// BDOS call for functions that return an address in HL (e.g. 31 DPB)
+uint16_t bdos_hl( uint8_t func, uint16_t arg ) {
+#asm
+    ld      hl, 2
+    add     hl, sp
+    ld      e, (hl)         ; de = arg
+    inc     hl
+    ld      d, (hl)
+    inc     hl
+    ld      c, (hl)         ; c = func
+    push    ix              ; some BIOSes do not keep IX
+    call    5
+    pop     ix
+#endasm
+}
+
+
+// direct BIOS call (CP/M 2.2): function n is at the WBOOT entry + 3*(n-1),
+// SELDSK (9) and SECTRAN (16) return HL, the others A (unlike bios())
+uint16_t bios_direct( uint8_t func, uint16_t bc, uint16_t de ) {
+#asm
+    ld      hl, 2
+    add     hl, sp
+    ld      e, (hl)         ; de = de
+    inc     hl
+    ld      d, (hl)
+    inc     hl
+    ld      c, (hl)         ; bc = bc
+    inc     hl
+    ld      b, (hl)
+    inc     hl
+    ld      a, (hl)         ; a = func
+    push    ix              ; some BIOSes do not keep IX
+    push    af              ; func for the result
+    ld      hl, bios_ret    ; the BIOS returns there
+    push    hl
+    push    de
+    ld      hl, (1)         ; WBOOT entry
+    ld      e, a
+    add     a, a
+    add     a, e            ; 3 * func
+    sub     3
+    ld      e, a
+    ld      d, 0
+    add     hl, de
+    pop     de
+    jp      (hl)
+bios_ret:
+    ld      e, a            ; A of the BIOS
+    pop     af              ; func
+    cp      9
+    jr      z, bios_end     ; SELDSK: HL
+    cp      16
+    jr      z, bios_end     ; SECTRAN: HL
+    ld      l, e
+    ld      h, 0
+bios_end:
+    pop     ix
+#endasm
+}
+
+
+#ifndef NOASM
+
+
+// compare two names "NAME.EXT", like strcmp, at most FILENAME_LEN chars
+int name_cmp( const char *a, const char *b ) {
+#asm
+    ld      hl, 2
+    add     hl, sp
+    ld      e, (hl)         ; de = b
+    inc     hl
+    ld      d, (hl)
+    inc     hl
+    ld      a, (hl)         ; hl = a
+    inc     hl
+    ld      h, (hl)
+    ld      l, a
+    ld      b, 13           ; FILENAME_LEN
+nc_loop:
+    ld      a, (de)
+    cp      (hl)            ; *b - *a
+    jr      nz, nc_diff
+    or      a               ; both NUL?
+    jr      z, nc_equal
+    inc     hl
+    inc     de
+    djnz    nc_loop
+nc_equal:
+    ld      hl, 0
+    jr      nc_end
+nc_diff:
+    ld      hl, 1           ; *b < *a -> a > b
+    jr      c, nc_end
+    ld      hl, -1
+nc_end:
+#endasm
+}
+
+
+// 11 byte directory name "NAME    EXT" with attribute bits -> "NAME.EXT"
+void dir_name( char *dst, const uint8_t *src ) {
+#asm
+    ld      hl, 2
+    add     hl, sp
+    ld      e, (hl)         ; de = src
+    inc     hl
+    ld      d, (hl)
+    inc     hl
+    ld      a, (hl)         ; hl = dst
+    inc     hl
+    ld      h, (hl)
+    ld      l, a
+    ex      de, hl          ; hl = src, de = dst
+    push    hl
+    ld      b, 8
+dn_name:
+    ld      a, (hl)
+    and     0x7F            ; strip attribute bit
+    cp      0x20            ; padding ends the name
+    jr      z, dn_type
+    ld      (de), a
+    inc     de
+    inc     hl
+    djnz    dn_name
+dn_type:
+    pop     hl
+    ld      bc, 8
+    add     hl, bc          ; hl = src + 8, the type
+    ld      a, (hl)
+    and     0x7F
+    cp      0x20            ; no type, no '.'
+    jr      z, dn_end
+    ld      a, 0x2E         ; '.'
+    ld      (de), a
+    inc     de
+    ld      b, 3
+dn_ext:
+    ld      a, (hl)
+    and     0x7F
+    cp      0x20
+    jr      z, dn_end
+    ld      (de), a
+    inc     de
+    inc     hl
+    djnz    dn_ext
+dn_end:
+    xor     a
+    ld      (de), a         ; NUL
+#endasm
+}
+
+
+// dump line "AAAA  HH HH .. HH  |ascii...........|" of 16 bytes into buf
+void hex_line( char *buf, const uint8_t *data, uint16_t addr ) {
+#asm
+    ld      hl, 2
+    add     hl, sp
+    ld      c, (hl)         ; bc = addr
+    inc     hl
+    ld      b, (hl)
+    inc     hl
+    ld      e, (hl)         ; de = data
+    inc     hl
+    ld      d, (hl)
+    inc     hl
+    ld      a, (hl)         ; hl = buf
+    inc     hl
+    ld      h, (hl)
+    ld      l, a
+    ld      a, b
+    call    hx_byte
+    ld      a, c
+    call    hx_byte
+    ld      (hl), 0x20
+    inc     hl
+    ld      (hl), 0x20
+    inc     hl
+    push    de              ; data again for the ASCII part
+    ld      b, 16
+hx_bytes:
+    ld      a, (de)
+    call    hx_byte
+    ld      (hl), 0x20
+    inc     hl
+    inc     de
+    djnz    hx_bytes
+    ld      (hl), 0x20
+    inc     hl
+    ld      (hl), 0x7C      ; '|'
+    inc     hl
+    pop     de
+    ld      b, 16
+hx_ascii:
+    ld      a, (de)
+    cp      0x20
+    jr      c, hx_dot
+    cp      0x7F
+    jr      c, hx_put
+hx_dot:
+    ld      a, 0x2E         ; '.'
+hx_put:
+    ld      (hl), a
+    inc     hl
+    inc     de
+    djnz    hx_ascii
+    ld      (hl), 0x7C      ; '|'
+    inc     hl
+    ld      (hl), 0
+    jr      hx_end
+
+hx_byte:                    ; a -> two hex digits at (hl)
+    push    af
+    rrca
+    rrca
+    rrca
+    rrca
+    call    hx_nibble
+    pop     af
+hx_nibble:                  ; low nibble of a -> digit at (hl)
+    push    de
+    ex      de, hl
+    and     0x0F
+    ld      hl, _hex_digits
+    add     a, l
+    ld      l, a
+    jr      nc, hx_nc
+    inc     h
+hx_nc:
+    ld      a, (hl)
+    ex      de, hl
+    pop     de
+    ld      (hl), a
+    inc     hl
+    ret
+hx_end:
+#endasm
+}
+
+
+// length of the printable run in s, ends before LF or ^Z, at most n chars
+uint8_t text_span( const char *s, uint8_t n ) {
+#asm
+    ld      hl, 2
+    add     hl, sp
+    ld      b, (hl)         ; b = n
+    inc     hl
+    inc     hl
+    ld      a, (hl)         ; hl = s
+    inc     hl
+    ld      h, (hl)
+    ld      l, a
+    ld      c, b
+    ld      a, b
+    or      a
+    jr      z, ts_stop
+ts_loop:
+    ld      a, (hl)
+    cp      0x0A            ; LF
+    jr      z, ts_stop
+    cp      0x1A            ; ^Z
+    jr      z, ts_stop
+    inc     hl
+    djnz    ts_loop
+ts_stop:
+    ld      a, c
+    sub     b               ; n - remaining
+    ld      l, a
+    ld      h, 0
+#endasm
+}
+
+
+#else // NOASM
+
+
+int name_cmp( const char *a, const char *b ) {
+    return strcmp( a, b );
+}
+
+
+void dir_name( char *dst, const uint8_t *src ) {
+    uint8_t i;
+    for ( i = 0; i < 8 && ( src[i] & 0x7F ) != ' '; ++i )
+        *dst++ = src[i] & 0x7F;
+    if ( ( src[8] & 0x7F ) != ' ' ) {
+        *dst++ = '.';
+        for ( i = 8; i < 11 && ( src[i] & 0x7F ) != ' '; ++i )
+            *dst++ = src[i] & 0x7F;
+    }
+    *dst = '\0';
+}
+
+
+void hex_line( char *buf, const uint8_t *data, uint16_t addr ) {
+    uint8_t i;
+    *buf++ = hex_digits[addr >> 12];
+    *buf++ = hex_digits[(addr >> 8) & 0x0F];
+    *buf++ = hex_digits[(addr >> 4) & 0x0F];
+    *buf++ = hex_digits[addr & 0x0F];
+    *buf++ = ' ';
+    *buf++ = ' ';
+    for ( i = 0; i < 16; ++i ) {
+        *buf++ = hex_digits[data[i] >> 4];
+        *buf++ = hex_digits[data[i] & 0x0F];
+        *buf++ = ' ';
+    }
+    *buf++ = ' ';
+    *buf++ = '|';
+    for ( i = 0; i < 16; ++i )
+        *buf++ = data[i] >= 0x20 && data[i] < 0x7F ? data[i] : '.';
+    *buf++ = '|';
+    *buf = '\0';
+}
+
+
+uint8_t text_span( const char *s, uint8_t n ) {
+    uint8_t i;
+    for ( i = 0; i < n && s[i] != '\n' && s[i] != 0x1A; ++i )
+        ;
+    return i;
+}
+
+
+#endif // NOASM
@@ -0,0 +1,137 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// LU libraries (.LBR): Enter lists the members read-only in the panel,
+// p->pattern is the library name. A member keeps its first record in
+// dirpos and its length in extent, view, dump and copy read only this
+// range with open_src(). Backspace goes back to the directory.
+
+
+// directory entry of a library, the first one describes the directory
+typedef struct {
+    uint8_t status; // 0 = active, 0xFE = deleted, 0xFF = unused
+    uint8_t name[11];
+    uint16_t index; // first record
+    uint16_t length; // records
+    uint16_t crc;
+    uint16_t created; // days since 1.1.1978, like CP/M 3
+    uint16_t updated;
+    uint16_t ctime; // MS-DOS format hhhhhmmmmmmsssss
+    uint16_t utime;
+    uint8_t pad; // unused bytes in the last record
+    uint8_t filler[5];
+} lbr_entry;
+
+
+static uint8_t bcd( uint8_t n ) {
+    return ( ( n / 10 ) << 4 ) | ( n % 10 );
+}
+
+
+// add the active entry e to the panel
+static void lbr_member( Panel *p, lbr_entry *e ) {
+    FileEntry *f = p->files + p->num_files;
+    uint16_t t = e->updated ? e->utime : e->ctime;
+
+    memset( f, 0, sizeof( FileEntry ) );
+    dir_name( f->cpmname, e->name );
+    f->extent = e->length;
+    f->dirpos = e->index;
+    if ( e->updated || e->created ) {
+        f->date = e->updated ? e->updated : e->created;
+        f->hour = bcd( t >> 11 );
+        f->minute = bcd( ( t >> 5 ) & 0x3F );
+        days_to_date( &(f->date) );
+    }
+    p->order[p->num_files] = p->num_files;
+    ++p->num_files;
+}
+
+
+// Enter on NAME.LBR: show the members, returns 0 if it is no library
+uint8_t lbr_open( Panel *p ) {
+    char lib[FILENAME_LEN];
+    const char *ext;
+    lbr_entry *e;
+    FileEntry tmp;
+    uint16_t r, recs, i, j;
+
+    if ( p->mode != PM_DIR || !p->num_files )
+        return 0;
+    strcpy( lib, FILE_AT( p, p->current_idx ).cpmname );
+    ext = strchr( lib, '.' );
+    if ( !ext || strcmp( ext, ".LBR" ) )
+        return 0;
+    prepare_fcb( lib, p, NULL );
+    if ( bdos( 15, fcb_src ) == 255 ) // BDOS function 15 (F_OPEN) - open file
+        return 0;
+
+    // only the directory records are read
+    for ( r = 0, recs = 1; r < recs; ++r ) {
+        *(uint16_t *)( fcb_src + 33 ) = r;
+        fcb_src[35] = 0;
+        if ( bdos( 33, fcb_src ) ) // BDOS function 33 (F_READRAND) - read random
+            break;
+        e = (lbr_entry *)0x80;
+        if ( !r ) { // the entry of the directory itself
+            if ( e->status || memcmp( e->name, "           ", 11 ) || e->index || !e->length )
+                return 0;
+            recs = e->length;
+            dcache_claim( p );
+            p->mode = PM_LBR;
+            strcpy( p->pattern, lib );
+            p->num_files = 0;
+            ++e;
+        }
+        for ( ; e < (lbr_entry *)0x100; ++e )
+            if ( !e->status && p->num_files < MAX_FILES )
+                lbr_member( p, e );
+    }
+    if ( p->mode != PM_LBR ) // record 0 not read: empty or truncated
+        return 0;
+
+    // name order for find_file(), LU keeps the directory sorted already
+    for ( i = 1; i < p->num_files; ++i ) {
+        memcpy( &tmp, p->files + i, sizeof( FileEntry ) );
+        for ( j = i; j && name_cmp( p->files[j - 1].cpmname, tmp.cpmname ) > 0; --j )
+            memcpy( p->files + j, p->files + j - 1, sizeof( FileEntry ) );
+        memcpy( p->files + j, &tmp, sizeof( FileEntry ) );
+    }
+    p->total_files = p->num_files;
+    p->win_base = 0;
+    p->current_idx = 0;
+    p->scroll_offset = 0;
+    sort_panel( p );
+    return 1;
+}
+
+
+// back to the directory, the cursor on the library
+void lbr_close( Panel *p ) {
+    char lib[FILENAME_LEN];
+    strcpy( lib, p->pattern );
+    load_directory( p );
+    goto_file( p, lib );
+}
@@ -68,8 +68,11 @@ void other_panel() {
 
 
 void change_drive( char k ) {
-    App.active_panel->drive = k;
-    load_directory(App.active_panel);
+    if ( !dcache_switch( App.active_panel, k ) ) { // not cached
+        App.active_panel->drive = k;
+        load_directory(App.active_panel);
+    }
+    dcache_used( k );
     refresh_ui( PAN_ACTIVE );
 }
 
@@ -79,7 +82,7 @@ void select_file() {
     int offset = (App.active_panel == &App.left) ? 1 : PANEL_WIDTH+1;
 
     // A. invert the selection state in memory
-    App.active_panel->files[idx].attrib ^= 0x80;
+    FILE_AT(App.active_panel, idx).attrib ^= 0x80;
 
     // B. redraw current line to show '*'
     // IMPORTANT: current_idx was not changed, line is drawn with cursor.
@@ -100,6 +103,8 @@ void select_file() {
 
 
 void line_up() {
+    if (App.active_panel->current_idx == 0)
+        window_prev(App.active_panel); // windowed directory: load the part before
     if (App.active_panel->current_idx > 0) {
         int old_idx = App.active_panel->current_idx;
         App.active_panel->current_idx--;
@@ -117,6 +122,8 @@ void line_up() {
 
 
 void line_down() {
+    if (App.active_panel->current_idx + 1 == App.active_panel->num_files)
+        window_next(App.active_panel); // windowed directory: load the next part
     if (App.active_panel->current_idx < App.active_panel->num_files - 1) {
         int old_idx = App.active_panel->current_idx;
         App.active_panel->current_idx++;
@@ -134,6 +141,8 @@ void line_down() {
 
 
 void page_up() {
+    if (App.active_panel->current_idx < VISIBLE_ROWS/2)
+        window_prev(App.active_panel);
     if (App.active_panel->current_idx >= VISIBLE_ROWS/2)
         App.active_panel->current_idx -= VISIBLE_ROWS/2;
     else
@@ -143,6 +152,8 @@ void page_up() {
 
 
 void page_down() {
+    if (App.active_panel->current_idx + VISIBLE_ROWS/2 >= App.active_panel->num_files)
+        window_next(App.active_panel);
     App.active_panel->current_idx += VISIBLE_ROWS/2;
     if (App.active_panel->current_idx >= App.active_panel->num_files)
         App.active_panel->current_idx = App.active_panel->num_files - 1;
@@ -151,87 +162,311 @@ void page_down() {
 
 
 void first_file() {
+    if (App.active_panel->win_base) // windowed directory, not at the start
+        load_window(App.active_panel, NULL, 0);
     App.active_panel->current_idx = 0;
     refresh_ui( PAN_ACTIVE );
 }
 
 
 void last_file() {
+    Panel *p = App.active_panel;
+    if (p->win_base + p->num_files < p->total_files) // windowed, not at the end
+        load_window(p, NULL, 1);
     App.active_panel->current_idx = App.active_panel->num_files - 1;
     refresh_ui( PAN_ACTIVE );
 }
 
 
+// select the sort order of the active panel, SORT_MODES -> next order
+void set_sort( uint8_t mode ) {
+    Panel *p = App.active_panel;
+    p->sort = mode < SORT_MODES ? mode : (p->sort + 1) % SORT_MODES;
+    sort_panel(p);
+    refresh_ui( PAN_ACTIVE );
+}
+
+
 uint8_t yes_no() {
     char k = wait_key_hw();
     return (k == 'y' || k == 'Y');
 }
 
 
+// FIND [pattern] [/U], without pattern the name of the current file,
+// /U searches all user areas
+void find( char *arg ) {
+    Panel *p = App.active_panel;
+    char *opt = strstr( arg, "/U" );
+    if ( opt ) {
+        *opt = '\0';
+        while ( opt > arg && opt[-1] == ' ' )
+            *--opt = '\0';
+    }
+    if ( !*arg ) {
+        if ( p->mode != PM_DIR || !p->num_files )
+            return;
+        arg = FILE_AT(p, p->current_idx).cpmname;
+    }
+    find_files( p, arg, opt != NULL );
+    refresh_ui( PAN_ACTIVE );
+}
+
+
+// FILTER [pattern]: show only the matching files, without pattern all
+void filter( char *arg ) {
+    Panel *p = App.active_panel;
+    while ( *arg == ' ' )
+        ++arg;
+    strncpy( p->filter, strcmp( arg, "*.*" ) ? arg : "", FILENAME_LEN - 1 );
+    p->filter[FILENAME_LEN - 1] = '\0';
+    load_directory( p );
+    refresh_ui( PAN_ACTIVE );
+}
+
+
+// Enter on a FIND result: go to the file
+void find_enter() {
+    Panel *dest = (App.active_panel == &App.left) ? &App.right : &App.left;
+    if ( find_jump( App.active_panel ) ) { // other user area
+        if ( dest->mode == PM_DIR )
+            load_directory( dest );
+        refresh_ui( PAN_BOTH );
+    } else
+        refresh_ui( PAN_ACTIVE );
+}
+
+
 void copy() {
     Panel *dest = (App.active_panel == &App.left) ? &App.right : &App.left;
+    if ( App.active_panel->mode == PM_FIND || dest->mode != PM_DIR )
+        return; // FIND result, no file operations, libraries are read-only
     // clear dialog box and ask
-    printf("\x1b[%d;1H\x1b[K COPY SELECTED FILE(S) TO %c:? (Y/N) ", PANEL_HEIGHT+1, dest->drive); // pos, erase EOL
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    printf(" COPY SELECTED FILE(S) TO %c:? (Y/N) ", dest->drive);
     if ( yes_no() )
         // Y: copy multiple files
         exec_multi_copy(App.active_panel, dest);
     // clear status line
-    printf("\x1b[%d;1H\x1b[K", PANEL_HEIGHT+1); // pos, erase EOL
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
     refresh_ui( PAN_OTHER );
 }
 
 
+// COPY d: d: ...: the selected files to several drives, each source
+// record is read once
+void fan_copy( const char *arg ) {
+    Panel *dest = (App.active_panel == &App.left) ? &App.right : &App.left;
+    char drives[FAN_MAX + 1];
+    uint8_t i;
+    int errors;
+
+    if ( App.active_panel->mode == PM_FIND || dest->mode != PM_DIR )
+        return; // FIND result, no file operations, the other panel is the buffer
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    if ( !fan_drives( arg, drives, App.active_panel->drive ) ) {
+        printf(" COPY d: [d: ...], UP TO %u OTHER DRIVES ", FAN_MAX);
+        wait_key_hw();
+    } else {
+        printf(" COPY SELECTED FILE(S) TO");
+        for ( i = 0; drives[i]; ++i )
+            printf(" %c:", drives[i]);
+        printf("? (Y/N) ");
+        if ( yes_no() && ( errors = exec_fan_copy(App.active_panel, dest, drives) ) ) {
+            gotoyx(PANEL_HEIGHT+1, 1);
+            erase_eol();
+            printf(" %d COPIES FAILED ", errors);
+            wait_key_hw();
+        }
+    }
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    refresh_ui( PAN_BOTH );
+}
+
+
 void delete() {
+    if ( App.active_panel->mode != PM_DIR )
+        return;
     // clear dialog box and ask
-    printf("\x1b[%d;1H\x1b[K DELETE SELECTED FILE(S)? (Y/N) ", PANEL_HEIGHT+1); // pos, erase EOL
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    printf(" DELETE SELECTED FILE(S)? (Y/N) ");
     if ( yes_no() ) {
         // Y: call master function
         exec_multi_delete(App.active_panel);
         load_directory(App.active_panel);
     }
     // clear status line
-    printf("\x1b[%d;1H\x1b[K", PANEL_HEIGHT+1); // pos, erase EOL
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
     refresh_ui( PAN_ACTIVE ); // file(s) deleted, refresh active panel
 }
 
 
-void help() {
-    hide_cursor();
-    printf( "\x1b[m\x1b[2J\x1b[H" ); // normal, cls, home
-    puts( "                           " );
-    puts( " #######  #     #   #####  " );
-    puts( "      #   ##   ##  #     # " );
-    puts( "     #    # # # #  #       " );
-    puts( "    #     #  #  #  #       " );
-    puts( "   #      #     #  #       " );
-    puts( "  #       #     #  #     # " );
-    puts( " #######  #     #   #####  " );
-    puts( "                           " );
-    puts( " ZMC v1.2 - Volney Torres " );
-
-    uint8_t line = 12;
-    printf( "\x1b[%dH", line );
-    printf( "A: ... P:\x1b[%d;32HSelect drive\n", line++ );
-    printf( "[TAB]\x1b[%d;32HChange panel\n", line++ );
-    printf( "[F3], TYPE, VIEW, CAT\x1b[%d;32HShow file\n", line++ );
-    printf( "[F4], DUMP, HEX\x1b[%d;32HHexdump file\n", line++ );
-    printf( "[F5], COPY, CP\x1b[%d;32HCopy file(s)\n", line++ );
-    printf( "[F8], DEL, ERA, RM\x1b[%d;32HDelete file(s)\n", line++ );
-    printf( "[F9], [ESC][ESC], QUIT, EXIT\x1b[%d;32HDelete file(s)\n", line++ );
-    wait_key_hw();
+// tag the differences in both panels
+void compare() {
+    Panel *dest = (App.active_panel == &App.left) ? &App.right : &App.left;
+    if ( App.active_panel->mode != PM_DIR || dest->mode != PM_DIR )
+        return;
+    if ( compare_panels(App.active_panel, dest, 1) == CMP_WINDOWED ) {
+        gotoyx(PANEL_HEIGHT+1, 1);
+        printf(" DIRECTORY TOO LARGE TO COMPARE ");
+        wait_key_hw();
+        gotoyx(PANEL_HEIGHT+1, 1);
+        erase_eol();
+    }
+    refresh_ui( PAN_BOTH );
+}
+
+
+// compare the files under the cursor of both panels byte by byte,
+// DUMP of the active one at the first difference
+void diff() {
+    Panel *dest = (App.active_panel == &App.left) ? &App.right : &App.left;
+    char name_l[FILENAME_LEN], name_r[FILENAME_LEN];
+    uint16_t n;
+    long at;
+    if ( !App.active_panel->num_files )
+        return;
+    show_progress( "DIFF", 1, 1, FILE_AT(App.active_panel, App.active_panel->current_idx).cpmname );
+    // the files are read into the file storage of both panels
+    strcpy( name_l, App.left.num_files ? FILE_AT(&App.left, App.left.current_idx).cpmname : "" );
+    strcpy( name_r, App.right.num_files ? FILE_AT(&App.right, App.right.current_idx).cpmname : "" );
+    at = diff_files( App.active_panel, dest, &n );
+    if ( at != -2 ) { // -2: nothing was read
+        reload_panel( &App.left, name_l );
+        reload_panel( &App.right, name_r );
+    }
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    if ( at == -2 ) {
+        printf(" CAN NOT READ BOTH FILES ");
+        wait_key_hw();
+    } else if ( at < 0 ) {
+        printf(" FILES ARE IDENTICAL ");
+        wait_key_hw();
+    } else {
+        printf(" FIRST DIFFERENCE AT %04lX, %u RECORD(S), DUMP? (Y/N) ", at, n);
+        if ( yes_no() ) {
+            dump_at = at;
+            dump_file(); // redraws the panels
+            return;
+        }
+    }
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    refresh_ui( PAN_BOTH );
+}
+
+
+// MAP: blocks of the drive of the active panel, defragmentation
+void disk_map_ui( void ) {
+    char name_l[FILENAME_LEN], name_r[FILENAME_LEN];
+
+    // the map uses the file storage of both panels
+    strcpy( name_l, App.left.num_files ? FILE_AT(&App.left, App.left.current_idx).cpmname : "" );
+    strcpy( name_r, App.right.num_files ? FILE_AT(&App.right, App.right.current_idx).cpmname : "" );
+    disk_map( App.active_panel );
+    reload_panel( &App.left, name_l );
+    reload_panel( &App.right, name_r );
+    clrscr();
+    refresh_ui( PAN_BOTH );
+}
+
+
+// DISKCOPY [/V]: image of the disk of the active panel on the drive of
+// the other panel, track by track with the BIOS, /V reads it back
+void diskcopy( const char *arg ) {
+    static const char *dc_msg[] = { "", "NOT THE SAME FORMAT", "NOT ENOUGH MEMORY",
+        "CAN NOT SELECT THE DRIVES", "READ ERROR", "WRITE ERROR", "VERIFY ERROR" };
+    Panel *src = App.active_panel;
+    Panel *dest = (src == &App.left) ? &App.right : &App.left;
+    char name_l[FILENAME_LEN], name_r[FILENAME_LEN];
+    uint16_t trk;
+    int rc = 0;
+
+    if ( dest->drive == src->drive )
+        return;
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    if ( bdos_hl( 29, 0 ) & ( 1 << ( dest->drive - 'A' ) ) ) { // BDOS function 29 (DRV_ROVEC) - R/O drives
+        printf(" %c: IS READ ONLY ", dest->drive);
+        wait_key_hw();
+    } else {
+        // the home drive holds ZMC.OVR and the snapshots of "!command"
+        printf(" DISKCOPY %c: TO %c:%s, ALL FILES ON %c: ARE LOST! (Y/N) ", src->drive, dest->drive,
+               dest->drive - 'A' == home_drive ? " (HOLDS ZMC.OVR)" : "", dest->drive);
+        rc = yes_no();
+    }
+    if ( rc ) {
+        // the copy uses the file storage of both panels
+        strcpy( name_l, App.left.num_files ? FILE_AT(&App.left, App.left.current_idx).cpmname : "" );
+        strcpy( name_r, App.right.num_files ? FILE_AT(&App.right, App.right.current_idx).cpmname : "" );
+        rc = disk_copy( src->drive - 'A', dest->drive - 'A', strstr( arg, "/V" ) != NULL, &trk );
+        disk_copy_done( dest->drive - 'A' );
+        reload_panel( &App.left, name_l );
+        reload_panel( &App.right, name_r );
+        gotoyx(PANEL_HEIGHT+1, 1);
+        erase_eol();
+        if ( rc == DC_READ || rc == DC_WRITE || rc == DC_VERIFY )
+            printf(" %s ON TRACK %u ", dc_msg[rc], trk);
+        else if ( rc )
+            printf(" %s ", dc_msg[rc]);
+        else
+            printf(" DISK %c: COPIED TO %c: ", src->drive, dest->drive);
+        wait_key_hw();
+    }
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    refresh_ui( PAN_BOTH );
+}
+
+
+// one-way sync: copy only the new and changed files to the other panel
+void sync_panels() {
+    Panel *dest = (App.active_panel == &App.left) ? &App.right : &App.left;
+    uint16_t n;
+    if ( dest->drive == App.active_panel->drive
+        || App.active_panel->mode != PM_DIR || dest->mode != PM_DIR )
+        return;
+    n = compare_panels(App.active_panel, dest, 0);
+    refresh_ui( PAN_ACTIVE );
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
+    if ( n == CMP_WINDOWED ) {
+        printf(" DIRECTORY TOO LARGE TO COMPARE ");
+        wait_key_hw();
+    } else if ( n == 0 ) {
+        printf(" %c: IS UP TO DATE ", dest->drive);
+        wait_key_hw();
+    } else {
+        printf(" SYNC %u FILE(S) TO %c:? (Y/N) ", n, dest->drive);
+        if ( yes_no() )
+            exec_multi_copy(App.active_panel, dest);
+    }
+    gotoyx(PANEL_HEIGHT+1, 1);
+    erase_eol();
     refresh_ui( PAN_BOTH );
 }
 
 
 int main(int argc, char** argv) {
+    home_drive = bdos( 25, 0 ); // BDOS function 25 (DRV_GET) - current drive
+
     // CP/M Plus has values for screen size in System Control Block
     if ( bdos( 12, NULL ) == 0x31 ) { // version == CP/M Plus
         // handle BDOS errors internally, do not exit
         bdos( 45, 0xFF ); // set BDOS return error mode 1
+#ifndef FIXED_COLS
         uint8_t scbpb[4] = { 0x1A, 0, 0, 0 }; // SCB parameter block, get col - 1
         *COLUMNS = bdos( 49, scbpb ) + 1;
         scbpb[0] = 0x1C; // lines - 1
         *LINES = bdos( 49, scbpb ) + 1;
+#endif
     }
 
     uint16_t total;
@@ -240,67 +475,90 @@ int main(int argc, char** argv) {
     // largest = address where the size of the largest available block in the heap will be stored
     mallinfo( &total, &largest );
 
-    // calculate number of file entries
-    MAX_FILES = largest / sizeof( FileEntry ) / 2;
+#ifdef OVERLAYS
+    ovl_open(); // before --CONFIG and --KEY, they live in an overlay
+#endif
+
+    int batch_argc = 0;
+    char **batch_argv = NULL;
+    uint8_t resume = 0;
 
     // cmd line argument "--config" shows address of screen size constants
     // in zmc.com to help the user to patch with a HEX editor, e.g. BE.
+    // "--" flags may appear anywhere, the other arguments are packed
+    // down to the start of argv[] for command line mode
+    char **args = argv;
     while ( --argc ) {
         ++argv;
         if ( !strcmp( *argv, "--CONFIG" ) ) {
-            uint16_t value = bdos( 12, NULL );
-            printf( "COLUMNS @ 0x%04X: %d\n", COLUMNS - 0x100, *COLUMNS );
-            printf( "LINES @ 0x%04X: %d\n", LINES - 0x100, *LINES );
-            printf( "MAX_FILES: %u\n", MAX_FILES );
+            show_config();
             return 0;
         } else if ( !strcmp( *argv, "--DEVEL" ) ) {
             ++DEVEL;
         } else if ( !strcmp( *argv, "--DEBUG" ) ) {
             ++DEBUG;
+        } else if ( !strcmp( *argv, "--PROFILE" ) ) {
+            ++PROFILE;
+        } else if ( !strcmp( *argv, "--RESUME" ) ) { // back from "!command"
+            ++resume;
         } else if ( !strcmp( *argv, "--KEY" ) ) {
-            // test for terminal function keys, exit with <ESC><ESC>
-            uint8_t k;
-            for(;;) {
-                static uint8_t esc = 0;
-                k = wait_key_hw();
-                printf( "0x%02X  ", k );
-                if ( k == ESC )
-                    puts( "ESC" );
-                else if (k < ESC )
-                    printf( "^%c\n", k + '@');
-                else    // show printable chars, else '.'
-                    printf( "%c\n", k >= ' ' && k < 128 ? k : '.' );
-                if ( esc && k == ESC ) // <ESC><ESC>
-                    return 0;
-                esc = k == ESC; // remember <ESC>
-            }
+            key_test();
+            return 0;
+        } else if ( **argv != '-' ) { // "ZMC COPY ...": command line mode
+            args[ batch_argc++ ] = *argv;
+            batch_argv = args;
         }
     }
 
+    if ( batch_argc ) // command line mode: no cache
+        *CACHE = 0;
+    // calculate number of file entries, each with its 16 bit sort index,
+    // the directory cache uses what the panels leave free
+    MAX_FILES = largest / ( sizeof( FileEntry ) + sizeof( uint16_t ) ) / 2;
+
     FileEntry *f_left;
     FileEntry *f_right;
 
-    f_left = calloc( MAX_FILES, sizeof( FileEntry ) ); // reserve and init heap space
+    // reserve and init heap space, file entries followed by the sort indices
+    f_left = calloc( MAX_FILES, sizeof( FileEntry ) + sizeof( uint16_t ) );
     if ( f_left == NULL ) {
         fprintf( stderr, "Not enough memory!\n" );
         return -1;
     }
-    f_right = calloc( MAX_FILES, sizeof( FileEntry ) ); // reserve and init heap space
+    f_right = calloc( MAX_FILES, sizeof( FileEntry ) + sizeof( uint16_t ) );
     if ( f_right == NULL ) {
         fprintf( stderr, "Not enough memory!\n" );
         return -1;
     }
 
     App.left.files = f_left;
+    App.left.order = (uint16_t *)(f_left + MAX_FILES);
     App.right.files = f_right;
+    App.right.order = (uint16_t *)(f_right + MAX_FILES);
+    dcache_init();
+
+    if ( PROFILE )
+        prof_start(); // count BDOS calls from now on
+
+    if ( batch_argv ) { // no UI
+        int status = batch( batch_argc, batch_argv );
+        if ( PROFILE )
+            prof_stop(); // write ZMC.PRF
+        batch_exit( status );
+        return status;
+    }
 
-    App.left.drive = '@'; App.left.active = 1; // current drive
-    App.right.drive = '@'; App.right.active = 0; // current drive
-    App.active_panel = &App.left;
+    if ( !resume || !shell_resume() ) { // no snapshot, start with the current drive
+        App.left.drive = '@'; App.left.active = 1; // current drive
+        App.right.drive = '@'; App.right.active = 0; // current drive
+        App.active_panel = &App.left;
 
-    load_directory(&App.left);
-    load_directory(&App.right);
-    printf("\x1b[?25l\x1b[2J\x1b[H"); // hide cursor, clear, home
+        load_directory(&App.left);
+        load_directory(&App.right);
+    }
+    dcache_used( App.right.drive );
+    dcache_used( App.left.drive );
+    clrscr(); // clear, home, hide cursor
     refresh_ui( PAN_BOTH ); // refresh/init both panels
 
     uint8_t loop = 1;
@@ -310,9 +568,13 @@ int main(int argc, char** argv) {
     *cp = '\0';
 
     while( loop ) { // terminal key input loop
+        while ( !key_ready() && dcache_idle() ) // read other drives meanwhile
+            ;
         k = wait_key_hw();
+        if ( PROFILE )
+            prof_begin();
         show_cursor();
-        if ( k > SPC ) {
+        if ( k > SPC || ( k == SPC && cp > cmdline ) ) { // SPC tags only on an empty line
             if ( cp < cmdline + CMDLINELEN ) {
                 *cp++ = toupper( k );
                 *cp = '\0';
@@ -320,8 +582,30 @@ int main(int argc, char** argv) {
         } else if ( k == BS ) {
             if ( cp > cmdline )
                 *--cp = '\0';
+            else if ( App.active_panel->mode == PM_LBR ) { // leave the library
+                lbr_close( App.active_panel );
+                refresh_ui( PAN_ACTIVE );
+            }
         } else if ( k == CR ) { // very simple cmd line parser
-            if ( cmdline[1] == ':' && *cmdline >= 'A' && *cmdline <= 'P' ) {
+            // QUICK VIEW stays for drive changes and opening a library, the
+            // other commands may need the files of the other panel
+            if ( ( *cmdline || App.active_panel->mode != PM_DIR ) && strcmp( cmdline, "QV" )
+                 && !( cmdline[1] == ':' && !cmdline[2] ) )
+                qview_close();
+            if ( !*cmdline && App.active_panel->mode == PM_FIND ) {
+                find_enter();
+            }
+            else if ( !*cmdline && App.active_panel->mode == PM_LBR ) {
+                view_file(); // Enter on a member
+            }
+            else if ( !*cmdline ) { // Enter on a library shows the members
+                if ( lbr_open( App.active_panel ) )
+                    refresh_ui( PAN_ACTIVE );
+            }
+            else if ( *cmdline == '!' ) { // run a CP/M command, come back
+                shell_out( cmdline + 1 );
+            }
+            else if ( cmdline[1] == ':' && *cmdline >= 'A' && *cmdline <= 'P' ) {
                 change_drive( *cmdline );
             }
             else if ( !strncmp( cmdline, "TYPE", 4 )
@@ -333,15 +617,52 @@ int main(int argc, char** argv) {
                 || !strncmp( cmdline, "HEX", 3 ) ) {
                 dump_file();
             }
+            else if ( !strncmp( cmdline, "COMPARE", 7 )
+                || !strncmp( cmdline, "CMP", 3 ) ) {
+                compare();
+            }
+            else if ( !strncmp( cmdline, "DISKCOPY", 8 ) ) {
+                diskcopy( cmdline + 8 );
+            }
+            else if ( !strcmp( cmdline, "QV" ) ) {
+                if ( qview )
+                    qview_close();
+                else
+                    qview_open();
+            }
+            else if ( !strncmp( cmdline, "MAP", 3 ) ) {
+                disk_map_ui();
+            }
+            else if ( !strncmp( cmdline, "DIFF", 4 )
+                || !strncmp( cmdline, "FC", 2 ) ) {
+                diff();
+            }
+            else if ( !strncmp( cmdline, "SYNC", 4 ) ) {
+                sync_panels();
+            }
             else if ( !strncmp( cmdline, "COPY", 4 )
                 || !strncmp( cmdline, "CP", 2 ) ) {
-                copy();
+                // COPY d: d: ... (or COPYd:d:): several drives, without
+                // drives the other panel
+                char *arg = cmdline + ( cmdline[1] == 'O' ? 4 : 2 );
+                while ( *arg == ' ' )
+                    ++arg;
+                if ( *arg )
+                    fan_copy( arg );
+                else
+                    copy();
             }
             else if ( !strncmp( cmdline, "DEL", 3 )
                 || !strncmp( cmdline, "ERA", 3 )
                 || !strncmp( cmdline, "RM", 2 ) ) {
                 delete();
             }
+            else if ( !strncmp( cmdline, "FILTER", 6 ) ) {
+                filter( cmdline + 6 );
+            }
+            else if ( !strncmp( cmdline, "FIND", 4 ) ) {
+                find( cmdline[4] == ' ' ? cmdline + 5 : cmdline + 4 );
+            }
             else if ( !strncmp( cmdline, "TOP", 3 )
                 || !strncmp( cmdline, "POS1", 4 ) ) {
                 first_file();
@@ -350,6 +671,14 @@ int main(int argc, char** argv) {
                 || !strncmp( cmdline, "END", 3 ) ) {
                 last_file();
             }
+            else if ( !strncmp( cmdline, "SORT", 4 ) ) {
+                static const char sort_keys[] = "NESDU"; // enum sort_mode
+                char *m = cmdline + 4; // "SORT N" or "SORTN"
+                while ( *m == ' ' )
+                    ++m;
+                m = *m ? strchr( sort_keys, *m ) : NULL;
+                set_sort( m ? m - sort_keys : SORT_MODES );
+            }
             else if ( !strncmp( cmdline, "HELP", 4 ) ) {
                 help();
             }
@@ -362,6 +691,7 @@ int main(int argc, char** argv) {
         }
         // here come the function keys
         else if ( k == TAB ) { // TAB: OTHER_PANEL
+            qview_close();
             other_panel();
         } else if (k == ' ' || k == 'V'-'@') { // ' ' or ^V -> SELECT
             select_file();
@@ -391,11 +721,21 @@ int main(int argc, char** argv) {
                     first_file();
                 } else if ( k == 'F' ) { // <END> = "<ESC>[F"
                     last_file();
-                } else if ( k == '1' ) { // F5 = "<ESC>[15~" / F8 = "<ESC>[19~"
+                } else if ( k == '1' ) { // F5 = "<ESC>[15~" / F6 = "<ESC>[17~" / F7 = "<ESC>[18~" / F8 = "<ESC>[19~"
                     k = wait_key_hw();
                     if ( k == '5' && wait_key_hw() == '~' ) { // F5 = "<ESC>[15~" COPY
+                        qview_close();
                         copy();
+                    } else if ( k == '7' && wait_key_hw() == '~' ) { // F6 = "<ESC>[17~" QUICK VIEW on/off
+                        if ( qview )
+                            qview_close();
+                        else
+                            qview_open();
+                    } else if ( k == '8' && wait_key_hw() == '~' ) { // F7 = "<ESC>[18~" FIND current file
+                        qview_close();
+                        find( "" );
                     } else if ( k == '9' && wait_key_hw() == '~' ) { // F8 = "<ESC>[19~" DELETE
+                        qview_close();
                         delete();
                     }
                 } else if ( k == '2' ) {
@@ -411,19 +751,31 @@ int main(int argc, char** argv) {
 	        if ( k == 'P' ) { // F1 = "<ESC>OP" HELP
                     help();
 	        }
+	        else if ( k == 'Q' ) { // F2 = "<ESC>OQ" next SORT order
+	            set_sort( SORT_MODES );
+	        }
 	        else if ( k == 'R' ) { // F3 = "<ESC>OR" VIEW
+	            qview_close();
 	            view_file();
 	        }
 		else if ( k == 'S' ) { // F4 = "<ESC>OS" DUMP
+		    qview_close();
 		    dump_file();
 		}
             }
         }
-        if ( loop )
+        if ( loop ) {
+            qview_update(); // the current file may have changed
+            if ( PROFILE )
+                prof_end();
             show_prompt();
+        }
     }
-    printf( "\x1b[?25h" ); // show cursor
-    printf( "\x1b[0m\x1b[2J\x1b[H" ); // normal, cls, home
+    if ( PROFILE )
+        prof_stop(); // write ZMC.PRF
+    set_normal();
+    clrscr();
+    show_cursor();
     return 0;
 }
 
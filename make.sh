@@ -3,9 +3,10 @@
 # -O3: maximal optimisation
 # -vn: no verbosity
 # -create-app: Build a .COM file
+# "make overlay" builds ovl/zmc.com + ovl/zmc.ovr with help and viewer as overlays
 
 zcc +cpm -O3 -vn -DAMALLOC -pragma-define:CRT_STACK_SIZE=1024 -Wall \
-main.c panel.c operations.c globals.c -o zmc.com -create-app
+main.c panel.c operations.c globals.c profile.c batch.c kernels.c find.c shell.c lbr.c unsq.c patch.c diff.c diskcopy.c defrag.c qview.c dcache.c help.c viewer.c -o zmc.com -create-app
 
 if [ $? -eq 0 ]; then
     echo "✅ Build OK: ZMC.COM generated."
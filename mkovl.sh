@@ -0,0 +1,50 @@
+#!/bin/bash
+# Build ZMC.OVR from the map file of the overlay root ZMC.COM
+# usage: mkovl.sh <root.map> <out.ovr> "<overlay 1 sources>" "<overlay 2 sources>" ...
+# The order of the overlays must match enum overlay in zmc.h.
+
+MAP=$1
+OVR=$2
+shift 2
+DIR=$(dirname "$OVR")
+
+# load address of the overlay region
+ORG=$(awk '$1 == "_ovl_area" { print $3 }' "$MAP" | tr -d '$')
+if [ -z "$ORG" ]; then
+    echo "❌ _ovl_area not found in $MAP."
+    exit 1
+fi
+
+# all public symbols of the root, the overlays link against them
+awk '/; addr, public/ { print "PUBLIC " $1; print "DEFC " $1 " = " $3 }' "$MAP" > "$DIR/root.asm"
+
+# directory record: entry 0 = region address and size, entry n = record, size
+rec=1
+dir=$(printf '%04X%04X' $((0x$ORG)) $OVL_SIZE)
+n=0
+for src in "$@"; do
+    n=$((n+1))
+    $ZCC -DOVL_MODULE -c $src -o "$DIR/ovl$n.o" || exit 1
+    z88dk-z80asm -b -r0x$ORG -o"$DIR/ovl$n.bin" "$DIR/ovl$n.o" "$DIR/root.asm" || exit 1
+    size=$(stat -c %s "$DIR/ovl$n.bin")
+    if [ $size -gt $OVL_SIZE ]; then
+        echo "❌ overlay $n ($src): $size bytes > OVL_SIZE $OVL_SIZE."
+        exit 1
+    fi
+    dir=$dir$(printf '%04X%04X' $rec $size)
+    rec=$((rec + (size + 127) / 128))
+done
+
+# little endian words, directory padded to one record
+le() { echo -n "$1" | sed -E 's/(..)(..)(..)(..)/\2\1\4\3/g' | xxd -r -p; }
+{
+    le "$dir"
+    head -c $((128 - 4 * (n + 1))) /dev/zero
+    for i in $(seq 1 $n); do
+        cat "$DIR/ovl$i.bin"
+        pad=$(( (128 - $(stat -c %s "$DIR/ovl$i.bin") % 128) % 128 ))
+        head -c $pad /dev/zero
+    done
+} > "$OVR"
+
+echo "✅ $OVR: $n overlays at 0x$ORG."
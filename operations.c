@@ -29,37 +29,53 @@ uint8_t fcb_src[36];
 uint8_t fcb_dst[36];
 
 
+// "NAME.EXT" -> "NAME    EXT" (FCB bytes 1..11),
+// '*' fills the rest of name or type with '?'
+void name_to_fcb( uint8_t *fcbname, const char *name ) {
+    uint8_t j;
+    memset( fcbname, ' ', 11 );
+    for ( j = 0; j < 8 && *name && *name != '.'; ++name )
+        if ( *name == '*' )
+            while ( j < 8 )
+                fcbname[j++] = '?';
+        else
+            fcbname[j++] = *name;
+    while ( *name && *name != '.' )
+        name++;
+    if ( *name == '.' )
+        name++;
+    for ( j = 8; j < 11 && *name; ++name )
+        if ( *name == '*' )
+            while ( j < 11 )
+                fcbname[j++] = '?';
+        else
+            fcbname[j++] = *name;
+}
+
+
+// match "NAME.EXT" against an 11 byte FCB pattern with '?'
+uint8_t match_name( const uint8_t *pattern, const char *name ) {
+    uint8_t fcbname[11];
+    uint8_t j;
+    name_to_fcb( fcbname, name );
+    for ( j = 0; j < 11; ++j )
+        if ( pattern[j] != '?' && pattern[j] != fcbname[j] )
+            return 0;
+    return 1;
+}
+
+
 void prepare_fcb( char *name, Panel *src, Panel *dst ) {
 // setup one or two FCBs for reading, copying or deleting
-    char *name_ptr = name;
     if ( src ) {
         memset(fcb_src, 0, sizeof(fcb_src));
         *fcb_src = (src->drive - 'A') + 1;
-        memset(fcb_src+1, ' ', 11);
-        for( uint8_t j = 0; j < 8 && name_ptr[j] != '.' && name_ptr[j] != '\0'; j++)
-            fcb_src[1+j] = name_ptr[j];
-        while( *name_ptr && *name_ptr != '.')
-            name_ptr++;
-        if( *name_ptr == '.') {
-            name_ptr++;
-            for(uint8_t j = 0; j < 3 && name_ptr[j] != '\0'; j++)
-                fcb_src[9+j] = name_ptr[j];
-        }
+        name_to_fcb( fcb_src+1, name );
     }
     if ( dst ) {
-        name_ptr = name;
         memset(fcb_dst, 0, sizeof(fcb_dst));
         *fcb_dst = (dst->drive - 'A') + 1;
-        memset(fcb_dst+1, ' ', 11);
-        for( uint8_t j = 0; j < 8 && name_ptr[j] != '.' && name_ptr[j] != '\0'; j++)
-            fcb_dst[1+j] = name_ptr[j];
-        while( *name_ptr && *name_ptr != '.')
-            name_ptr++;
-        if( *name_ptr == '.') {
-            name_ptr++;
-            for(uint8_t j = 0; j < 3 && name_ptr[j] != '\0'; j++)
-                fcb_dst[9+j] = name_ptr[j];
-        }
+        name_to_fcb( fcb_dst+1, name );
     }
 }
 
@@ -116,138 +132,335 @@ void days_to_date( void *date ) {
 }
 
 
-// Three-way compare function for the name field of FileEntry used by qsort
+// Three-way compare function for name and extent of FileEntry used by qsort
 static int fileNameExtentCompare(const void* a, const void* b) {
-    // 1. compare cpmname
-    // 2. if equal, compare extent and mark files with lower extent as invalid
-    int res = strcmp( ((const FileEntry*)a)->cpmname, ((const FileEntry*)b)->cpmname );
+    int res = name_cmp( ((const FileEntry*)a)->cpmname, ((const FileEntry*)b)->cpmname );
     if ( res ) // names are different
         return res;
-    // only the 1st extent has date/time info
-    if (((const FileEntry*)a)->date  && !((const FileEntry*)b)->date )
-        memcpy( &((FileEntry*)b)->date, &((const FileEntry*)a)->date, 6 );
-    else if (((const FileEntry*)b)->date  && !((const FileEntry*)a)->date )
-        memcpy( &((FileEntry*)a)->date, &((const FileEntry*)b)->date, 6 );
-    // now compare the extents
-    res = ((const FileEntry*)a)->extent - ((const FileEntry*)b)->extent;
-    if ( res < 0 )
-        *((FileEntry*)a)->cpmname = '~';
-    else
-        *((FileEntry*)b)->cpmname = '~';
-    return res;
+    // same file, lower extent first
+    if ( ((const FileEntry*)a)->extent == ((const FileEntry*)b)->extent )
+        return 0;
+    return ((const FileEntry*)a)->extent < ((const FileEntry*)b)->extent ? -1 : 1;
 }
 
 
 // Three-way compare function for the name field of FileEntry used by qsort
 static int fileNameCompare(const void* a, const void* b) {
     // setting up rules for comparison
-    return strcmp( ((const FileEntry*)a)->cpmname, ((const FileEntry*)b)->cpmname );
+    return name_cmp( ((const FileEntry*)a)->cpmname, ((const FileEntry*)b)->cpmname );
 }
 
 
-void load_directory(Panel *p) {
+// The files array stays sorted by name, other orders only permute the
+// 16 bit indices in p->order. The keys are compact fields of FileEntry:
+// size = total records, date = year, month/day, hour/minute,
+// unsorted = position in the directory scan.
+// Ties are broken by the index, i.e. by name.
+static FileEntry *sort_files; // files array of the panel being sorted
+
+
+static const char *file_ext( const char *name ) {
+    while ( *name && *name != '.' )
+        ++name;
+    return name; // "" for files without extension
+}
+
+
+static int extCompare(const void* a, const void* b) {
+    const FileEntry *fa = sort_files + *(const uint16_t *)a;
+    const FileEntry *fb = sort_files + *(const uint16_t *)b;
+    int res = strcmp( file_ext( fa->cpmname ), file_ext( fb->cpmname ) );
+    return res ? res : *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+
+static int sizeCompare(const void* a, const void* b) { // largest first
+    uint16_t ka = sort_files[*(const uint16_t *)a].extent;
+    uint16_t kb = sort_files[*(const uint16_t *)b].extent;
+    if ( ka != kb )
+        return ka < kb ? 1 : -1;
+    return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+
+static int dateCompare(const void* a, const void* b) { // newest first
+    const FileEntry *fa = sort_files + *(const uint16_t *)a;
+    const FileEntry *fb = sort_files + *(const uint16_t *)b;
+    uint16_t ka, kb;
+    if ( fa->date != fb->date )
+        return fa->date < fb->date ? 1 : -1;
+    ka = (fa->month << 8) | fa->day;
+    kb = (fb->month << 8) | fb->day;
+    if ( ka == kb ) {
+        ka = (fa->hour << 8) | fa->minute; // BCD sorts like binary
+        kb = (fb->hour << 8) | fb->minute;
+    }
+    if ( ka != kb )
+        return ka < kb ? 1 : -1;
+    return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+
+static int dirposCompare(const void* a, const void* b) {
+    uint16_t ka = sort_files[*(const uint16_t *)a].dirpos;
+    uint16_t kb = sort_files[*(const uint16_t *)b].dirpos;
+    return ka == kb ? 0 : ka < kb ? -1 : 1;
+}
+
+
+// (re)build the display order of a panel according p->sort,
+// the cursor stays on the same file
+void sort_panel(Panel *p) {
+    uint16_t idx;
+    uint16_t cur = p->num_files ? p->order[p->current_idx] : 0;
+
+    for ( idx = 0; idx < p->num_files; ++idx )
+        p->order[idx] = idx;
+
+    // windowed directory: the other orders need all files
+    if ( p->total_files > p->num_files )
+        p->sort = SORT_NAME;
+
+    sort_files = p->files;
+    if ( p->sort == SORT_EXT )
+        qsort( p->order, p->num_files, sizeof(uint16_t), extCompare );
+    else if ( p->sort == SORT_SIZE )
+        qsort( p->order, p->num_files, sizeof(uint16_t), sizeCompare );
+    else if ( p->sort == SORT_DATE )
+        qsort( p->order, p->num_files, sizeof(uint16_t), dateCompare );
+    else if ( p->sort == SORT_NONE )
+        qsort( p->order, p->num_files, sizeof(uint16_t), dirposCompare );
+
+    // find the row of the file under the cursor
+    for ( idx = 0; idx < p->num_files; ++idx )
+        if ( p->order[idx] == cur ) {
+            p->current_idx = idx;
+            break;
+        }
+}
+
+
+// sort file names and extents and merge the extents of each file
+// into the last one, returns the new number of entries
+static uint16_t merge_extents( FileEntry *files, uint16_t count ) {
+    FileEntry *it, *out, *end = files + count;
+
+    if ( count < 2 )
+        return count;
+    qsort((void *)files, count, sizeof(FileEntry), fileNameExtentCompare);
+
+    // the comparator must not modify the entries while qsort runs,
+    // the merge is one pass over the sorted array
+    out = files;
+    for ( it = files + 1; it < end; ++it ) {
+        if ( !name_cmp( it->cpmname, out->cpmname ) ) { // next extent
+            // only the 1st extent has date/time info
+            if ( !it->date )
+                memcpy( &it->date, &out->date, 6 );
+            // the surviving (last) extent keeps the directory position of the first
+            if ( out->dirpos < it->dirpos )
+                it->dirpos = out->dirpos;
+        } else
+            ++out;
+        if ( out != it )
+            memcpy( out, it, sizeof(FileEntry) );
+    }
+    return out - files + 1;
+}
+
+
+// name within the window [lo, hi], NULL = open end
+static uint8_t in_window( const char *name, const char *lo, const char *hi, uint8_t hi_incl ) {
+    int cmp;
+    if ( lo && name_cmp( name, lo ) < 0 )
+        return 0;
+    if ( hi ) {
+        cmp = name_cmp( name, hi );
+        if ( cmp > 0 || ( cmp == 0 && !hi_incl ) )
+            return 0;
+    }
+    return 1;
+}
+
+
+// Load the part of the directory that fits into p->files:
+// forward the first files with name >= key (NULL: from the start),
+// back the last files with name <= key (NULL: up to the end).
+// When the array is full the extents are merged and the half farther
+// from key is dropped, the scan continues with the narrowed window.
+// p->total_files counts the first extents of all files,
+// p->win_base is the number of files before p->files[0].
+// With load_idle set (the entries p can hold) a key stops the scan,
+// then it returns 1.
+uint16_t load_idle = 0;
+
+uint8_t load_window(Panel *p, const char *key, uint8_t back) {
     cpm_dir *dir_entry;
     uint16_t count = 0;
-    uint8_t result;
-
+    uint16_t pos = 0; // position in directory scan
+    uint16_t total = 0, below = 0; // files, files before / up to key
+    uint8_t result, exm, dropped = 0, steps = 0;
+    static char bound[FILENAME_LEN]; // window end after a drop
+    const char *lo = back ? NULL : key;
+    const char *hi = back ? key : NULL;
+    uint8_t hi_incl = 1;
+    uint16_t max = load_idle ? load_idle : MAX_FILES;
+
+    dcache_claim( p ); // cached listings there move to the other panel
+    p->mode = PM_DIR;
     p->num_files = 0;
     p->current_idx = 0;
     p->scroll_offset = 0;
     p->show_date = 0;
 
-    if (p->drive == '@') // '@' -> select current drive
-        p->drive = bdos( 25, fcb_src ) + 'A';
     /* 1. change drive to fetch the complete directory */
     bdos(14, p->drive - 'A'); 
+    // extent mask, entries with S2 = 0 and EX <= EXM are first extents
+    exm = ((uint8_t *)bdos_hl(31, 0))[4]; // BDOS function 31 (DRV_DPB) - get DPB address
 
     /* 2. Prepare FCB to match all files (*.*) and all extents */
     memset(fcb_src, 0, sizeof(fcb_src));
     fcb_src[0] = 0; // current drive
     memset(&fcb_src[1], '?', 11+4); // name, type, EXTENT,S1,S2,RC: "????????.???"????
+    if ( *p->filter ) // the BDOS returns only the matching entries
+        name_to_fcb( fcb_src+1, p->filter );
     /* 3. Find 1st file */
     result = bdos(17, fcb_src); // BDOS function 17 (F_SFIRST) - search for first
 
-    while (result != 255 && count < MAX_FILES) { // OK: result = 0..3
+    while (result != 255) { // OK: result = 0..3
         /* record is in default DMA (0x80) */
         /* 32 bytes dir entries according index (0-3) in 128 bytes record */
         dir_entry = (cpm_dir *)(0x80 + (result * 32));
 
         /* only if not erased (0xE5) */
         if (dir_entry->user != 0xE5) {
-            char clean_name[9], clean_ext[4];
-
-            // clean attribute bits and spaces
-            for(int i=0; i<8; i++) clean_name[i] = dir_entry->name[i] & 0x7F;
-            clean_name[8] = '\0';
-            for(int i=0; i<3; i++) clean_ext[i] = dir_entry->type[i] & 0x7F;
-            clean_ext[3] = '\0';
-            // save attributes
-            p->files[count].attrib = 0;
-            for ( uint8_t bit = 0; bit < 3; ++bit )
-            if (dir_entry->type[bit] > 0x7F)
-                p->files[count].attrib |= 1 << bit;
-
-            p->files[count].extent = ((uint16_t)(dir_entry->s2) * 32 ) + dir_entry->ex;
-            p->files[count].rc = dir_entry->rc;
-            // Format (e.g.: "NAME    EXT" -> "NAME.EXT")
-            if ( *clean_ext != ' ' ) // "NAME.EXT"
-                sprintf(p->files[count].cpmname, "%s.%s", strtok(clean_name, " "), clean_ext);
-            else // "NAME"
-                strcpy( p->files[count].cpmname, strtok(clean_name, " ") );
-
-            // handle the CP/M3 date/time entry
-            // check if date time info exists in the 4th 32 byte directory entry
-            if ( result < 3 && *((uint8_t *)(0xE0)) == '!' ) { // yes
-                if ( PANEL_WIDTH >= 40 ) // no date/time display for narrow panels
-                    p->show_date = 1;
-                date_time_dir *dtd = (date_time_dir *)(0xE0);
-                p->files[count].date = dtd->dt[result].update.date;
-                p->files[count].hour = dtd->dt[result].update.hour;
-                p->files[count].minute = dtd->dt[result].update.minute;
-                days_to_date( &(p->files[count].date) );
-            } else { // no date/time file info
-                p->files[count].date = 0;
-                p->files[count].month = 0;
-                p->files[count].day = 0;
-                p->files[count].hour = 0;
-                p->files[count].minute = 0;
+            FileEntry *f = &p->files[count];
+            // Format (e.g.: "NAME    EXT" -> "NAME.EXT"), clean attribute bits
+            dir_name( f->cpmname, dir_entry->name );
+            if ( dir_entry->s2 == 0 && dir_entry->ex <= exm ) { // 1st extent
+                ++total;
+                if ( key ) {
+                    int cmp = name_cmp( f->cpmname, key );
+                    if ( cmp < 0 || ( back && cmp == 0 ) )
+                        ++below;
+                }
+            }
+            if ( in_window( f->cpmname, lo, hi, hi_incl ) ) {
+                // save attributes
+                f->attrib = 0;
+                for ( uint8_t bit = 0; bit < 3; ++bit )
+                if (dir_entry->type[bit] > 0x7F)
+                    f->attrib |= 1 << bit;
+
+                f->extent = ((uint16_t)(dir_entry->s2) * 32 ) + dir_entry->ex;
+                f->rc = dir_entry->rc;
+                f->dirpos = pos;
+
+                // handle the CP/M3 date/time entry
+                // check if date time info exists in the 4th 32 byte directory entry
+                if ( result < 3 && *((uint8_t *)(0xE0)) == '!' ) { // yes
+                    if ( PANEL_WIDTH >= 40 ) // no date/time display for narrow panels
+                        p->show_date = 1;
+                    date_time_dir *dtd = (date_time_dir *)(0xE0);
+                    f->date = dtd->dt[result].update.date;
+                    f->hour = dtd->dt[result].update.hour;
+                    f->minute = dtd->dt[result].update.minute;
+                    days_to_date( &(f->date) );
+                } else { // no date/time file info
+                    f->date = 0;
+                    f->month = 0;
+                    f->day = 0;
+                    f->hour = 0;
+                    f->minute = 0;
+                }
+                if ( ++count == max ) { // full, merge extents first
+                    count = merge_extents( p->files, count );
+                    if ( count > max - max / 4 ) { // still full
+                        uint16_t half = count / 2;
+                        strcpy( bound, p->files[half].cpmname );
+                        if ( back ) { // keep the upper half
+                            memmove( p->files, p->files + half, (count-half)*sizeof(FileEntry) );
+                            count -= half;
+                            lo = bound;
+                        } else { // keep the lower half
+                            count = half;
+                            hi = bound;
+                            hi_incl = 0;
+                        }
+                        dropped = 1;
+                    }
+                }
             }
-            count++;
+            ++pos;
         }
 
+        // idle prefetch: a key is looked for after a few entries
+        if ( load_idle && !( ++steps & 3 ) && key_ready() ) {
+            p->num_files = 0;
+            return 1;
+        }
         /* find all other files */
         result = bdos(18, fcb_src); // BDOS function 18 (F_SNEXT) - search for next
     }
 
-    // sort file names and extents,
-    // mark all extents except the last one
-    // move (most of) the marked extents to the end of list
+    count = merge_extents( p->files, count );
 
-    qsort((void *)p->files, count, sizeof(FileEntry), fileNameExtentCompare);
+    for ( uint16_t f_idx = 0; f_idx < count; ++f_idx )
+        p->files[f_idx].extent = ( (p->files[f_idx].extent << 7 ) + p->files[f_idx].rc);
 
-    uint16_t f_idx;
+    if ( !key ) // window from the start or up to the end
+        below = back ? total : 0;
+    if ( !key && !dropped ) // complete directory
+        total = count;
+    p->num_files = count;
+    p->total_files = total;
+    p->win_base = back && below > count ? below - count : back ? 0 : below;
+    sort_panel(p);
+    p->current_idx = 0;
+    dcache_loaded( p );
+    return 0;
+}
 
-    // remove all marked extents at the end of the array
-    f_idx = count;
-    while (f_idx-- && *(p->files[f_idx].cpmname ) == '~' )
-        --count;
 
-    // remove marked extents within the array, copy array one up
-    FileEntry *it = p->files;
-    FileEntry *end = &p->files[count];
-    while ( it < end ) {
-        while ( *((char *)it->cpmname) == '~' ) {
-            memcpy( it, it+1, (end-it-1)*sizeof(FileEntry) );
-            --count;
-            --end;
-        }
-        ++it;
-    }
+void load_directory(Panel *p) {
+    if (p->drive == '@') // '@' -> select current drive
+        p->drive = bdos( 25, fcb_src ) + 'A';
+    load_window(p, NULL, 0);
+}
 
-    for ( uint16_t f_idx = 0; f_idx < count; ++f_idx )
-        p->files[f_idx].extent = ( (p->files[f_idx].extent << 7 ) + p->files[f_idx].rc);
 
-    p->num_files = count;
+// Windowed directory: load the part after the visible page,
+// the page and the cursor stay on the same files, 0 = at the end
+uint8_t window_next(Panel *p) {
+    char key[FILENAME_LEN];
+    uint16_t cur = p->current_idx - p->scroll_offset;
+    if ( p->win_base + p->num_files >= p->total_files || !p->scroll_offset )
+        return 0;
+    strcpy( key, p->files[p->scroll_offset].cpmname );
+    load_window( p, key, 0 );
+    p->current_idx = cur < p->num_files ? cur : 0;
+    return 1;
+}
+
+
+// Windowed directory: load the part before, ending with the visible page
+uint8_t window_prev(Panel *p) {
+    char key[FILENAME_LEN];
+    uint16_t last, cur, top;
+    if ( !p->win_base || !p->num_files )
+        return 0;
+    last = p->scroll_offset + VISIBLE_ROWS - 1;
+    if ( last >= p->num_files )
+        last = p->num_files - 1;
+    strcpy( key, p->files[last].cpmname );
+    cur = last - p->current_idx; // rows above the end of the page
+    top = last - p->scroll_offset;
+    load_window( p, key, 1 );
+    if ( p->num_files <= top )
+        return 1;
+    p->current_idx = p->num_files - 1 - cur;
+    p->scroll_offset = p->num_files - 1 - top;
+    return 1;
 }
 
 
@@ -255,7 +468,7 @@ void load_directory(Panel *p) {
 int delete_file() {
     Panel *p = App.active_panel;
     if (p->num_files == 0) return -1;
-    prepare_fcb(p->files[p->current_idx].cpmname, p, NULL );
+    prepare_fcb(FILE_AT(p, p->current_idx).cpmname, p, NULL );
     return bdos(19, fcb_src); // BDOS function 19 (F_DELETE) - delete file
 }
 
@@ -265,7 +478,7 @@ int copy_file(Panel *src, Panel *dst) {
     // any files to copy?
     if (src->num_files == 0) return -1;
     // fill the FCBs
-    prepare_fcb(src->files[src->current_idx].cpmname, src, dst);
+    prepare_fcb(FILE_AT(src, src->current_idx).cpmname, src, dst);
     // prepare transfer
     bdos(19, fcb_dst); // BDOS function 19 (F_DELETE) - delete file
     if (bdos(15, fcb_src) == 255) return -2; // BDOS function 15 - Open directory
@@ -280,174 +493,679 @@ int copy_file(Panel *src, Panel *dst) {
 }
 
 
-void show_header() {
-    printf("\x1b[2J\x1b[H\x1b[?25l"); // erase, home, hide cursor
+// transfer buffer, XFER_RECS records are read before they are written,
+// this limits the switching between source and destination drive
+uint8_t xfer_buf[XFER_RECS * 128];
+
+
+uint16_t src_base = 0; // PM_LBR: first record of the member
+uint16_t src_recs = 0xFFFF; // records to read, 0xFFFF = up to EOF
+
+
+// open file f of panel p with fcb_src for sequential reads, a library
+// member starts at its first record, returns 255 on error
+uint8_t open_src( Panel *p, FileEntry *f ) {
+    uint8_t rc;
+    src_base = 0;
+    src_recs = 0xFFFF;
+    prepare_fcb( p->mode == PM_LBR ? p->pattern : f->cpmname, p, NULL );
+    rc = bdos(15, fcb_src); // BDOS function 15 (F_OPEN) - open file
+    if ( rc == 255 || p->mode != PM_LBR )
+        return rc;
+    src_base = f->dirpos;
+    src_recs = f->extent;
+    if ( !src_recs )
+        return 0;
+    // after a random read the next sequential read gets the same record
+    *(uint16_t *)( fcb_src + 33 ) = src_base;
+    fcb_src[35] = 0;
+    return bdos(33, fcb_src) ? 255 : 0; // BDOS function 33 (F_READRAND) - read random
 }
 
 
-void show_footer( const char *action, const char *file_name ) {
-    printf("\x1b[7m %s: %s (<SPACE>: more | <ESC>: exit) \x1b[0m", action, file_name); // inv / normal
+// Resumable copy of large files: the records go to $ZMC.TMP on dst and
+// every CKPT_RECS records the file is closed, then the directory has its
+// blocks, and the journal $ZMC.CPY on dst gets the number of records
+// that are safe. At the end $ZMC.TMP gets the name of the file, the old
+// file is deleted only then, unless plan_fits() needed its space
+// (ckpt_del_first). There is one journal per drive. A later copy of the
+// same file to the same drive continues after the last checkpoint: a
+// random read positions the source, random writes (BDOS 34) continue
+// $ZMC.TMP.
+#define CKPT_RECS 128 // records between checkpoints, one 16K extent
+
+typedef struct {
+    char magic[4]; // "ZMCC"
+    char src_drive;
+    uint8_t user;
+    char src_name[FILENAME_LEN]; // PM_LBR: the library
+    uint16_t src_base;
+    char dst_name[FILENAME_LEN];
+    uint16_t total; // records of the file
+    uint16_t done; // records of $ZMC.TMP that are on the disk
+} copy_jnl;
+
+static copy_jnl jnl;
+static uint8_t fcb_jnl[36];
+static uint8_t ckpt_del_first; // the replaced file is deleted before the copy
+
+
+static void ckpt_fcb( uint8_t *fcb, char drive, const char *name ) {
+    memset( fcb, 0, 36 );
+    *fcb = drive - 'A' + 1;
+    name_to_fcb( fcb + 1, name );
 }
 
 
-void view_file() {
-    // unsigned char fcb[36];
-    Panel *p = App.active_panel;
-    int i;
-    int line_count = -1;
-    char *name_ptr = p->files[p->current_idx].cpmname;
-    char *temp_ptr;
-
-    if (p->num_files == 0) return;
-    show_header();
-    prepare_fcb(p->files[p->current_idx].cpmname, p, NULL);
-    // open and read
-    if (bdos(15, fcb_src) != 255) { // BDOS function 15 - Open directory
-        while (bdos(20, fcb_src) == 0) { // BDOS function 20 (F_READ) - read next record
-            for (i = 0; i < 128; i++) {
-                char c = *((char *)(0x80 + i));
-                if (c == 0x1A) goto end_of_file; // EOF (Ctrl+Z)
-                putchar(c);
-                if (c == '\n') {
-                    putchar('\r'); // Retorno de carro para CP/M
-                    line_count++;
-                    // Pausa cuando se llena la pantalla (aprox VISIBLE_ROWS líneas)
-                    if (line_count >= PANEL_HEIGHT) {
-                        show_footer( "VIEW", name_ptr );
-                        if (wait_key_hw() == 27) goto esc_file;
-                        printf("\r\x1b[K"); // CR, erase EOL
-                        line_count = 0;
-                    }
-                }
-            }
-        }
-    } else {
-        printf("\r\nError opening file.");
+// record 0 of the journal, random read (33) or write (34)
+static uint8_t jnl_rw( uint8_t func ) {
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    if ( func == 34 ) {
+        memset( (void *)0x80, 0, 128 );
+        memcpy( (void *)0x80, &jnl, sizeof( jnl ) );
     }
-end_of_file:
-    printf("\r\n\x1b[7m --- End Of File --- \x1b[0m"); // inv / normal
-    wait_key_hw();
-esc_file:
-    clrscr(); // clear screen, hide cursor
-    refresh_ui( PAN_BOTH );
+    fcb_jnl[33] = fcb_jnl[34] = fcb_jnl[35] = 0;
+    if ( bdos( func, fcb_jnl ) ) // BDOS function 33/34 (F_READRAND/F_WRITERAND)
+        return 1;
+    if ( func == 33 )
+        memcpy( &jnl, (void *)0x80, sizeof( jnl ) );
+    return 0;
 }
 
 
-// HEX and ASCII dump (16 bytes per line)
-void dump_file() {
-    Panel *p = App.active_panel;
-    int i, j, line_count = -1;
-    long address = 0;
-    char *name_ptr = p->files[p->current_idx].cpmname;
+// the directory gets the blocks of the open file fcb, CP/M 3 with a
+// partial close (F5'), CP/M 2.2 goes on writing after a close.
+// Returns 1 on error.
+uint8_t partial_close( uint8_t *fcb ) {
+    uint8_t rc;
+    if ( bdos( 12, NULL ) >= 0x30 )
+        fcb[5] |= 0x80;
+    rc = bdos( 16, fcb ); // BDOS function 16 (F_CLOSE) - close file
+    fcb[5] &= 0x7F;
+    return rc == 255;
+}
 
-    if (p->num_files == 0) return;
 
-    show_header();
-    prepare_fcb(p->files[p->current_idx].cpmname, p, NULL);
+// $ZMC.TMP has done records on the disk
+static uint8_t ckpt_commit( uint16_t done ) {
+    if ( partial_close( fcb_dst ) )
+        return 1;
+    jnl.done = done;
+    if ( jnl_rw( 34 ) ) // BDOS function 34 (F_WRITERAND) - write random
+        return 1;
+    if ( bdos( 12, NULL ) >= 0x30 )
+        bdos( 48, 0 ); // BDOS function 48 (DRV_FLUSH) - write the buffers of the BDOS
+    return 0;
+}
 
-    if (bdos(15, fcb_src) != 255) { // BDOS function 15 - Open directory
-        while (bdos(20, fcb_src) == 0) { // BDOS function 20 (F_READ) - read next record
-            for (i = 0; i < 128; i += 16) {
-                printf("%04X  ", (unsigned int)address);
-                for (j = 0; j < 16; j++) {
-                    printf("%02X ", *((unsigned char *)(0x80 + i + j)));
-                }
-                printf(" |");
-                for (j = 0; j < 16; j++) {
-                    unsigned char c = *((unsigned char *)(0x80 + i + j));
-                    if (c >= 32 && c <= 126) putchar(c);
-                    else putchar('.');
-                }
-                printf("|\r\n");
 
-                address += 16;
-                line_count++;
+// continue the interrupted copy in the journal? BATCH always does.
+// drop: the journal is of another file, may the new copy replace it?
+// BATCH keeps it, this file fails.
+static uint8_t ckpt_ask( uint8_t drop ) {
+    uint8_t pct = (uint32_t)jnl.done * 100 / jnl.total;
+    if ( BATCH ) {
+        if ( drop )
+            printf( "  SKIPPED, $ZMC.CPY HOLDS THE COPY OF %s AT %u%%\n", jnl.dst_name, pct );
+        else
+            printf( "  RESUMED AT %u%%\n", pct );
+        return !drop;
+    }
+    gotoyx(SCREEN_HEIGHT-1, 1);
+    erase_eol();
+    set_invers();
+    if ( drop ) // one journal per drive
+        printf(" DROP THE RESUMABLE COPY OF %s AT %u%%? (Y/N) ", jnl.dst_name, pct);
+    else
+        printf(" RESUME %s AT %u%%? (Y/N, N DROPS IT) ", jnl.dst_name, pct);
+    set_normal();
+    return ( wait_key_hw() | 0x20 ) == 'y';
+}
 
-                if (line_count >= PANEL_HEIGHT) {
-                    show_footer( "DUMP", name_ptr );
-                    if (wait_key_hw() == 27) goto esc_file;
-                    printf("\r\x1b[K"); // CR, erase EOL
-                    line_count = 0;
-                }
+
+static int copy_resumable( Panel *src, Panel *dst, uint16_t f_idx, uint8_t del ) {
+    FileEntry *f = &src->files[f_idx];
+    const char *src_name = src->mode == PM_LBR ? src->pattern : f->cpmname;
+    uint8_t user = bdos( 32, 0xFF ); // BDOS function 32 (F_USERNUM) - get user number
+    uint8_t fcb[36];
+    uint16_t rec = 0, left;
+    uint8_t n, i, resume = 0;
+    int err = 0;
+
+    if ( open_src( src, f ) == 255 )
+        return -1;
+    ckpt_fcb( fcb_jnl, dst->drive, "$ZMC.CPY" );
+    ckpt_fcb( fcb_dst, dst->drive, "$ZMC.TMP" );
+    if ( bdos( 15, fcb_jnl ) != 255 && !jnl_rw( 33 ) && !memcmp( jnl.magic, "ZMCC", 4 ) ) { // BDOS function 15 (F_OPEN) - open file
+        if ( jnl.src_drive == src->drive && jnl.user == user
+             && !strcmp( jnl.src_name, src_name ) && jnl.src_base == src_base
+             && !strcmp( jnl.dst_name, f->cpmname ) && jnl.total == f->extent ) {
+            if ( bdos( 15, fcb_dst ) != 255 ) // BDOS function 15 (F_OPEN) - open file
+                resume = ckpt_ask( 0 );
+        } else if ( !ckpt_ask( 1 ) )
+            return -1;
+    }
+    if ( del && ckpt_del_first ) { // its space is needed
+        ckpt_fcb( fcb, dst->drive, f->cpmname );
+        bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file
+        del = 0;
+    }
+    if ( resume ) {
+        rec = jnl.done;
+        // the source from record rec, the next sequential read gets it
+        *(uint16_t *)( fcb_src + 33 ) = src_base + rec;
+        fcb_src[35] = 0;
+        bdos( 26, xfer_buf ); // BDOS function 26 (F_DMAOFF) - set DMA address
+        if ( rec < jnl.total && bdos( 33, fcb_src ) ) // BDOS function 33 (F_READRAND) - read random
+            err = -1;
+    } else { // a new copy, an older one to dst is given up
+        ckpt_fcb( fcb_dst, dst->drive, "$ZMC.TMP" );
+        bdos( 19, fcb_dst ); // BDOS function 19 (F_DELETE) - delete file
+        bdos( 19, fcb_jnl ); // BDOS function 19 (F_DELETE) - delete file
+        memset( &jnl, 0, sizeof( jnl ) );
+        memcpy( jnl.magic, "ZMCC", 4 );
+        jnl.src_drive = src->drive;
+        jnl.user = user;
+        strcpy( jnl.src_name, src_name );
+        jnl.src_base = src_base;
+        strcpy( jnl.dst_name, f->cpmname );
+        jnl.total = f->extent;
+        if ( bdos( 22, fcb_jnl ) == 255 || jnl_rw( 34 ) || partial_close( fcb_jnl ) // BDOS function 22 (F_MAKE) - create file
+             || bdos( 22, fcb_dst ) == 255 ) // BDOS function 22 (F_MAKE) - create file
+            return -1;
+    }
+
+    for ( left = jnl.total - rec; !err && left; ) {
+        for ( n = 0; n < XFER_RECS && left; ++n, --left ) {
+            bdos( 26, xfer_buf + n * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+            if ( bdos( 20, fcb_src ) ) { // BDOS function 20 (F_READ) - read next record
+                left = 0; // shorter than its directory entries
+                break;
             }
         }
-    } else {
-        printf("\r\nError opening file.");
+        for ( i = 0; i < n && !err; ++i, ++rec ) {
+            bdos( 26, xfer_buf + i * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+            *(uint16_t *)( fcb_dst + 33 ) = rec;
+            fcb_dst[35] = 0;
+            if ( bdos( 34, fcb_dst ) ) // BDOS function 34 (F_WRITERAND) - write random
+                err = -1; // disk or directory full
+        }
+        if ( !err && !( rec % CKPT_RECS ) && ckpt_commit( rec ) )
+            err = -1;
+        // ESC stops, the copy can be resumed later
+        if ( !err && !BATCH && key_ready() && wait_key_hw() == ESC )
+            err = -1;
+    }
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    if ( err ) {
+        bdos( 16, fcb_dst ); // BDOS function 16 (F_CLOSE) - close file
+        return err;
+    }
+
+    // all records are safe, then the file gets its name
+    if ( ckpt_commit( rec ) )
+        return -1;
+    bdos( 16, fcb_dst ); // BDOS function 16 (F_CLOSE) - close file
+    if ( del ) {
+        ckpt_fcb( fcb, dst->drive, f->cpmname );
+        bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file
     }
-    printf("\r\n\x1b[7m --- End Of File --- \x1b[0m"); // inv / normal
-    wait_key_hw();
-    esc_file:
-    clrscr(); // clear screen, hide cursor
-    refresh_ui( PAN_BOTH );
+    ckpt_fcb( fcb, dst->drive, "$ZMC.TMP" );
+    name_to_fcb( fcb + 17, f->cpmname );
+    if ( bdos( 23, fcb ) == 255 ) // BDOS function 23 (F_RENAME) - rename file
+        return -1;
+    bdos( 19, fcb_jnl ); // BDOS function 19 (F_DELETE) - delete file
+    return 0;
 }
 
 
-// copy a specific file by its index
-int copy_file_by_index(Panel *src, Panel *dst, uint16_t f_idx) {
-    prepare_fcb(src->files[f_idx].cpmname, src, dst);
-    bdos(19, fcb_dst); // BDOS function 19 (F_DELETE) - delete file
-    if (bdos(15, fcb_src) == 255) return -1; // BDOS function 15 - Open directory
+// copy a specific file by its index, del: the file may exist on dst
+int copy_file_by_index(Panel *src, Panel *dst, uint16_t f_idx, uint8_t del) {
+    int err = 0;
+    uint8_t n, i;
+    uint16_t left;
+    if ( src->files[f_idx].extent > CKPT_RECS ) // large file, resumable
+        return copy_resumable( src, dst, f_idx, del );
+    prepare_fcb(src->files[f_idx].cpmname, NULL, dst);
+    if ( del )
+        bdos(19, fcb_dst); // BDOS function 19 (F_DELETE) - delete file
+    if (open_src(src, &src->files[f_idx]) == 255) return -1;
     if (bdos(22, fcb_dst) == 255) return -1; // BDOS function 22 (F_MAKE) - create file
-    while (bdos(20, fcb_src) == 0) // BDOS function 20 (F_READ) - read next record
-        if (bdos(21, fcb_dst) != 0) break; // BDOS function 21 (F_WRITE) - write next record
+    left = src_recs;
+    do {
+        for ( n = 0; n < XFER_RECS && left; ++n, --left ) {
+            bdos(26, xfer_buf + n * 128); // BDOS function 26 (F_DMAOFF) - set DMA address
+            if ( bdos(20, fcb_src) ) // BDOS function 20 (F_READ) - read next record
+                break;
+        }
+        for ( i = 0; i < n; ++i ) {
+            bdos(26, xfer_buf + i * 128); // BDOS function 26 (F_DMAOFF) - set DMA address
+            if ( bdos(21, fcb_dst) ) { // BDOS function 21 (F_WRITE) - write next record
+                err = -1; // disk or directory full
+                break;
+            }
+        }
+    } while ( !err && n == XFER_RECS );
+    bdos(26, 0x80); // BDOS function 26 (F_DMAOFF) - default DMA
     bdos(16, fcb_dst); // BDOS function 16 - Close directory
+    return err;
+}
+
+
+// binary search of a name in the name sorted files, -1 = not loaded
+int find_file( Panel *p, const char *name ) {
+    int lo = 0, hi = p->num_files - 1;
+    while ( lo <= hi ) {
+        int mid = ( lo + hi ) >> 1;
+        int cmp = name_cmp( p->files[mid].cpmname, name );
+        if ( !cmp )
+            return mid;
+        if ( cmp < 0 )
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+
+// put the cursor on the file name, a windowed directory is loaded
+// from there if needed (name not in p->files), returns 0 if it is gone
+uint8_t goto_file( Panel *p, const char *name ) {
+    int idx = find_file( p, name );
+    uint16_t row;
+    if ( idx < 0 && p->total_files > p->num_files ) {
+        load_window( p, name, 0 );
+        idx = find_file( p, name );
+    }
+    if ( idx < 0 )
+        return 0;
+    for ( row = 0; row < p->num_files; ++row )
+        if ( p->order[row] == idx ) {
+            p->current_idx = row;
+            break;
+        }
+    return 1;
+}
+
+
+// read the panel again after its storage was used as a buffer
+// (viewer tables, disk copy), the cursor goes to file name
+void reload_panel( Panel *p, const char *name ) {
+    char lib[FILENAME_LEN];
+    uint8_t mode = p->mode;
+
+    strcpy( lib, p->pattern );
+    load_directory( p ); // a FIND result becomes the directory
+    if ( mode == PM_LBR ) {
+        goto_file( p, lib );
+        lbr_open( p );
+    }
+    if ( *name )
+        goto_file( p, name );
+}
+
+
+// Copy planner: the tagged files (or the current one) as indices into
+// src->files, PLAN_DEL if the file may exist on dst and has to be deleted.
+// A complete listing of dst shows which files are not there.
+static uint16_t plan_copy( Panel *src, Panel *dst, uint16_t *plan ) {
+    uint8_t complete = dst->mode == PM_DIR && !*dst->filter
+                       && dst->total_files == dst->num_files;
+    uint16_t i, n = 0;
+
+    for ( i = 0; i < src->num_files; ++i )
+        if ( src->files[i].attrib & B_SEL )
+            plan[n++] = i;
+    if ( n == 0 && src->num_files )
+        plan[n++] = src->order[src->current_idx];
+    for ( i = 0; i < n; ++i )
+        if ( !complete || find_file( dst, src->files[plan[i]].cpmname ) >= 0 )
+            plan[i] |= PLAN_DEL;
+    return n;
+}
+
+
+// blocks and directory entries of a file with recs records
+static uint16_t file_blocks( uint16_t recs, uint8_t bsh ) {
+    return ( recs + ( 1 << bsh ) - 1 ) >> bsh;
+}
+
+static uint16_t file_entries( uint16_t recs, uint8_t exm ) {
+    uint16_t per_entry = ( exm + 1 ) << 7; // records of one directory entry
+    return recs ? ( recs + per_entry - 1 ) / per_entry : 1;
+}
+
+
+// Preflight: do the planned files fit into the free blocks and directory
+// entries of dst? Files replaced on dst give their space back. A large
+// file is copied next to the one it replaces, only if the space of those
+// is needed too ckpt_del_first deletes them before.
+static uint8_t plan_fits( Panel *src, Panel *dst, uint16_t *plan, uint16_t n ) {
+    uint8_t *dpb;
+    uint8_t bsh, exm, result;
+    uint16_t dsm, drm, i, used = 0;
+    uint32_t free_blocks = 0, need_blocks = 0, late_blocks = 0;
+    int32_t free_dir, need_dir = 0, late_dir = 0;
+
+    ckpt_del_first = 0;
+    bdos(14, dst->drive - 'A'); // BDOS function 14 (DRV_SET) - select disk
+    dpb = (uint8_t *)bdos_hl(31, 0); // BDOS function 31 (DRV_DPB) - get DPB address
+    bsh = dpb[2];
+    exm = dpb[4];
+    dsm = *(uint16_t *)(dpb + 5); // last block number
+    drm = *(uint16_t *)(dpb + 7); // last directory entry number
+
+    if ( bdos(12, NULL) >= 0x30 ) { // CP/M 3, the allocation vector may be banked
+        bdos(46, dst->drive - 'A'); // BDOS function 46 (DRV_SPACE) - free records at DMA
+        free_blocks = ( *(uint32_t *)0x80 & 0xFFFFFFL ) >> bsh;
+    } else { // CP/M 2.2, count the free bits of the allocation vector
+        uint8_t *alv = (uint8_t *)bdos_hl(27, 0); // BDOS function 27 (DRV_ALLOCVEC)
+        i = 0;
+        do { // blocks 0..dsm
+            if ( !( alv[i >> 3] & ( 0x80 >> ( i & 7 ) ) ) )
+                ++free_blocks;
+        } while ( i++ != dsm );
+    }
+
+    // used directory entries, all users, incl. labels and time stamps
+    memset(fcb_dst, 0, 36);
+    fcb_dst[0] = '?'; // all entries of the default drive
+    memset(&fcb_dst[1], '?', 15);
+    result = bdos(17, fcb_dst); // BDOS function 17 (F_SFIRST) - search for first
+    while ( result != 255 ) {
+        if ( *(uint8_t *)( 0x80 + result * 32 ) != 0xE5 )
+            ++used;
+        result = bdos(18, fcb_dst); // BDOS function 18 (F_SNEXT) - search for next
+    }
+    free_dir = (int32_t)drm + 1 - used;
+
+    for ( i = 0; i < n; ++i ) {
+        uint16_t recs = src->files[plan[i] & ~PLAN_DEL].extent;
+        int old = plan[i] & PLAN_DEL ? find_file( dst, src->files[plan[i] & ~PLAN_DEL].cpmname ) : -1;
+        need_blocks += file_blocks( recs, bsh );
+        need_dir += file_entries( recs, exm );
+        if ( old < 0 )
+            continue;
+        if ( recs > CKPT_RECS ) { // replaced after the copy
+            late_blocks += file_blocks( dst->files[old].extent, bsh );
+            late_dir += file_entries( dst->files[old].extent, exm );
+        } else { // replaced, its space is freed by the delete
+            free_blocks += file_blocks( dst->files[old].extent, bsh );
+            free_dir += file_entries( dst->files[old].extent, exm );
+        }
+    }
+    if ( need_blocks <= free_blocks && need_dir <= free_dir )
+        return 1;
+    free_blocks += late_blocks;
+    free_dir += late_dir;
+    if ( need_blocks <= free_blocks && need_dir <= free_dir )
+        return ckpt_del_first = 1;
+
+    if ( !BATCH ) {
+        gotoyx(SCREEN_HEIGHT-1, 1);
+        erase_eol();
+        set_invers();
+    }
+    if ( need_blocks > free_blocks ) // K = blocks << bsh >> 3
+        printf(" %c: FULL: NEED %luK, FREE %luK ", dst->drive,
+               ( need_blocks << bsh ) >> 3, ( free_blocks << bsh ) >> 3);
+    else
+        printf(" %c: DIRECTORY FULL: NEED %ld, FREE %ld ", dst->drive, need_dir, free_dir);
+    if ( BATCH )
+        putchar('\n');
+    else {
+        set_normal();
+        wait_key_hw();
+    }
     return 0;
 }
 
 
-/* 2. process multi selections */
-void exec_multi_copy(Panel *src, Panel *dst) {
-    int i, marcados = 0, procesados = 0;
+// progress of a multi file operation in the status line,
+// in BATCH mode one line per file
+void show_progress( const char *action, int n, int total, const char *name ) {
+    if ( BATCH ) {
+        printf( "[%d/%d] %s: %s\n", n, total, action, name );
+        return;
+    }
+    gotoyx(SCREEN_HEIGHT-1, 1);
+    erase_eol();
+    set_invers();
+    if ( total > 1 )
+        printf(" [%d/%d] %s: %s ", n, total, action, name);
+    else
+        printf(" %s: %s... ", action, name);
+    set_normal();
+}
+
+
+// same size and, if both disks have time stamps, same update time
+static uint8_t same_file( const FileEntry *a, const FileEntry *b ) {
+    if ( a->extent != b->extent )
+        return 0;
+    if ( !a->date || !b->date ) // no time stamps on one disk
+        return 1;
+    return !memcmp( &a->date, &b->date, 6 ); // date, month, day, hour, minute
+}
+
+
+static void tag_file( FileEntry *f, uint8_t on ) {
+    if ( on )
+        f->attrib |= B_SEL;
+    else
+        f->attrib &= ~B_SEL;
+}
+
 
-    for (i = 0; i < src->num_files; i++) {
-        if (src->files[i].attrib & B_SEL) marcados++;
+// Tag the files of src that are missing in dst or differ in size/date,
+// with 'both' also the files of dst that are missing in src or differ.
+// Both files arrays are sorted by name, one merge pass is O(n+m).
+// Returns the number of tagged files in src, CMP_WINDOWED if a panel
+// holds only a window of its directory, nothing is tagged then.
+uint16_t compare_panels( Panel *src, Panel *dst, uint8_t both ) {
+    FileEntry *a = src->files, *a_end = src->files + src->num_files;
+    FileEntry *b = dst->files, *b_end = dst->files + dst->num_files;
+    uint16_t n = 0;
+    int res;
+
+    // the files outside the window would be missing
+    if ( src->total_files != src->num_files || dst->total_files != dst->num_files )
+        return CMP_WINDOWED;
+
+    while ( a < a_end || b < b_end ) {
+        if ( a == a_end )
+            res = 1;
+        else if ( b == b_end )
+            res = -1;
+        else
+            res = name_cmp( a->cpmname, b->cpmname );
+        if ( res < 0 ) { // only in src
+            tag_file( a++, 1 );
+            ++n;
+        } else if ( res > 0 ) { // only in dst
+            tag_file( b++, both );
+        } else {
+            res = !same_file( a, b );
+            tag_file( a++, res );
+            tag_file( b++, both && res );
+            n += res;
+        }
     }
+    return n;
+}
 
-    if (marcados == 0) {
-        printf("\x1b[%d;1H\x1b[7m Copying: %s... \x1b[0m",
-               SCREEN_HEIGHT-1, src->files[src->current_idx].cpmname);
-        copy_file_by_index(src, dst, src->current_idx);
-    } else {
-        for (i = 0; i < src->num_files; i++) {
-            if (src->files[i].attrib & B_SEL) {
-                procesados++;
-                printf("\x1b[%d;1H\x1b[7m [%d/%d] Copying: %s \x1b[0m",
-                       SCREEN_HEIGHT-1, procesados, marcados, src->files[i].cpmname);
 
-                // USAR EL NOMBRE CORRECTO AQUÍ:
-                copy_file_by_index(src, dst, i);
-                src->files[i].attrib &= ~B_SEL;
+/* 2. process multi selections, return the number of failed files */
+int exec_multi_copy(Panel *src, Panel *dst) {
+    uint16_t *plan = dst->order; // scratch, dst is reloaded at the end
+    uint16_t i, n;
+    int errors = 0;
+
+    n = plan_copy(src, dst, plan);
+    if ( !plan_fits(src, dst, plan, n) ) // nothing copied, tags stay
+        errors = n;
+    else {
+        for (i = 0; i < n; i++) {
+            uint16_t f_idx = plan[i] & ~PLAN_DEL;
+            show_progress( "Copying", i + 1, n, src->files[f_idx].cpmname );
+            if ( copy_file_by_index(src, dst, f_idx, ( plan[i] & PLAN_DEL ) != 0) ) {
+                ++errors;
+                if ( BATCH )
+                    printf( "  ERROR\n" );
             }
         }
+        for (i = 0; i < src->num_files; i++)
+            src->files[i].attrib &= ~B_SEL;
     }
     load_directory(dst);
     // the refresh will be done by main.c after calling this function.
+    return errors;
+}
+
+// "B: C: D:" -> "BCD", the number of drives, 0 if arg is not a list of
+// up to FAN_MAX drives other than src
+uint8_t fan_drives( const char *arg, char *drives, char src ) {
+    uint8_t n = 0;
+    for ( ;; ) {
+        while ( *arg == ' ' )
+            ++arg;
+        if ( !*arg )
+            break;
+        if ( arg[0] < 'A' || arg[0] > 'P' || arg[1] != ':' || arg[0] == src
+             || n == FAN_MAX || memchr( drives, arg[0], n ) )
+            return 0;
+        drives[n++] = arg[0];
+        arg += 2;
+    }
+    drives[n] = '\0';
+    return n;
+}
+
+
+static uint8_t fcb_fan[FAN_MAX][36]; // one destination FCB per drive
+
+
+// copy file f_idx of src to all drives, each block of records is read
+// once to buf and written to every drive, a drive with an error is left
+// out for the rest of the file, returns the number of failed drives
+static uint8_t fan_copy_file( Panel *src, uint16_t f_idx, const char *drives,
+                              uint8_t *buf, uint16_t buf_recs ) {
+    uint8_t n = strlen( drives ), live = 0, made, t;
+    uint16_t left, got, r;
+
+    if ( open_src( src, &src->files[f_idx] ) == 255 )
+        return n;
+    for ( t = 0; t < n; ++t ) {
+        memset( fcb_fan[t], 0, 36 );
+        fcb_fan[t][0] = drives[t] - 'A' + 1;
+        name_to_fcb( fcb_fan[t] + 1, src->files[f_idx].cpmname );
+        bdos( 19, fcb_fan[t] ); // BDOS function 19 (F_DELETE) - delete file
+        if ( bdos( 22, fcb_fan[t] ) != 255 ) // BDOS function 22 (F_MAKE) - create file
+            live |= 1 << t;
+    }
+    made = live;
+    left = src_recs;
+    do {
+        for ( got = 0; got < buf_recs && left; ++got, --left ) {
+            bdos( 26, buf + got * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+            if ( bdos( 20, fcb_src ) ) // BDOS function 20 (F_READ) - read next record
+                break;
+        }
+        for ( t = 0; t < n; ++t )
+            for ( r = 0; r < got && ( live & ( 1 << t ) ); ++r ) {
+                bdos( 26, buf + r * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+                if ( bdos( 21, fcb_fan[t] ) ) // BDOS function 21 (F_WRITE) - write next record
+                    live &= ~( 1 << t ); // disk or directory full
+            }
+    } while ( live && got == buf_recs );
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    for ( r = 0, t = 0; t < n; ++t ) {
+        if ( made & ( 1 << t ) )
+            bdos( 16, fcb_fan[t] ); // BDOS function 16 (F_CLOSE) - close file
+        r += !( live & ( 1 << t ) );
+    }
+    return r;
+}
+
+
+// Fan-out copy: the tagged files (or the current one) of src to every
+// drive in drives, the source records are read once. dst is scratch:
+// its listing checks the room on each drive, its storage is the read
+// buffer, it is read again at the end. Returns the failed copies.
+int exec_fan_copy( Panel *src, Panel *dst, const char *drives ) {
+    uint16_t *plan = dst->order; // after the files, not in the buffer
+    uint8_t *buf = (uint8_t *)dst->files;
+    uint16_t buf_recs = MAX_FILES * sizeof( FileEntry ) / 128;
+    char home = dst->drive;
+    uint16_t i, n = 0;
+    uint8_t t;
+    int errors = 0;
+
+    if ( !buf_recs ) {
+        buf = xfer_buf;
+        buf_recs = XFER_RECS;
+    }
+    for ( t = 0; drives[t]; ++t ) { // all drives must have room first
+        dst->drive = drives[t];
+        load_directory( dst );
+        n = plan_copy( src, dst, plan );
+        if ( !plan_fits( src, dst, plan, n ) ) { // nothing copied, tags stay
+            errors = n;
+            break;
+        }
+    }
+    if ( !errors ) {
+        dcache_claim( dst ); // the buffer
+        for ( i = 0; i < n; i++ ) {
+            uint16_t f_idx = plan[i] & ~PLAN_DEL;
+            show_progress( "Copying", i + 1, n, src->files[f_idx].cpmname );
+            if ( ( t = fan_copy_file( src, f_idx, drives, buf, buf_recs ) ) ) {
+                errors += t;
+                if ( BATCH )
+                    printf( "  ERROR ON %u DRIVE(S)\n", t );
+            }
+        }
+        for ( i = 0; i < src->num_files; i++ )
+            src->files[i].attrib &= ~B_SEL;
+    }
+    dst->drive = home;
+    load_directory( dst );
+    return errors;
 }
 
-void exec_multi_delete(Panel *p) {
-    int i, marcados = 0, procesados = 0;
+
+int exec_multi_delete(Panel *p) {
+    int i, marcados = 0, procesados = 0, errors = 0;
     // count number of selections
     for (i = 0; i < p->num_files; i++) {
         if (p->files[i].attrib & B_SEL) marcados++;
     }
     if (marcados == 0) {
         // if none selected, delete  the current file (original functionality)
-        printf("\x1b[%d;1H\x1b[K Deleting: %s... ", SCREEN_HEIGHT-1, p->files[p->current_idx].cpmname);
-        delete_file(p);
+        show_progress( "Deleting", 1, 1, FILE_AT(p, p->current_idx).cpmname );
+        if ( delete_file(p) == 255 )
+            ++errors;
     } else {
         // batch deletion
         for (i = 0; i < p->num_files; i++) {
             if (p->files[i].attrib & B_SEL) {
                 procesados++;
-                printf("\x1b[%d;1H\x1b[K [%d/%d] Deleting: %s ", // pos, erase to EOL
-                       SCREEN_HEIGHT-1,  procesados, marcados, p->files[i].cpmname);
-
+                show_progress( "Deleting", procesados, marcados, p->files[i].cpmname );
                 prepare_fcb(p->files[i].cpmname, p, NULL);
-                bdos(19, fcb_src); // BDOS function 19 (F_DELETE) - delete file
+                if ( bdos(19, fcb_src) == 255 ) { // BDOS function 19 (F_DELETE) - delete file
+                    ++errors;
+                    if ( BATCH )
+                        printf( "  ERROR\n" );
+                }
                 p->files[i].attrib &= ~B_SEL;
             }
         }
     }
     // clear dialog part
-    printf("\x1b[%d;1H\x1b[K", SCREEN_HEIGHT-1 ); // pos, erase EOL
+    if ( !BATCH ) {
+        gotoyx(SCREEN_HEIGHT-1, 1);
+        erase_eol();
+    }
+    return errors;
 }
@@ -0,0 +1,112 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// Overlay loader. ZMC.OVR starts with a directory record, followed by
+// the overlay images, each padded to full records:
+//   entry 0: load address and size of the overlay region (build check)
+//   entry n: first record and size in bytes of overlay n
+// All overlays are linked to ovl_area and share it, an overlay must not
+// call into another overlay. Entry point is ovl_main() at ovl_area.
+
+uint8_t ovl_area[OVL_SIZE];
+
+typedef struct {
+    uint16_t rec;  // first record (entry 0: load address)
+    uint16_t size; // size in bytes
+} ovl_dir;
+
+static ovl_dir ovl_tab[OVL_MAX];
+static uint8_t ovl_fcb[36];
+static uint8_t ovl_loaded = 0; // overlay currently in ovl_area
+static uint8_t ovl_num = 0; // number of overlays in ZMC.OVR
+
+
+// open ZMC.OVR on the drive ZMC was started from, the FCB keeps the
+// drive because ZMC changes the current drive when panels are loaded
+void ovl_open() {
+    memset( ovl_fcb, 0, sizeof( ovl_fcb ) );
+    *ovl_fcb = home_drive + 1;
+    memcpy( ovl_fcb+1, "ZMC     OVR", 11 );
+    if ( bdos( 15, ovl_fcb ) == 255 ) // BDOS function 15 (F_OPEN) - open file
+        return;
+    // directory record 0 -> DMA
+    if ( bdos( 20, ovl_fcb ) ) // BDOS function 20 (F_READ) - read next record
+        return;
+    memcpy( ovl_tab, (void *)0x80, sizeof( ovl_tab ) );
+    if ( ovl_tab[0].rec != (uint16_t)ovl_area || ovl_tab[0].size != OVL_SIZE )
+        return; // ZMC.OVR does not match this ZMC.COM
+    while ( ovl_num + 1 < OVL_MAX && ovl_tab[ovl_num + 1].size )
+        ++ovl_num;
+}
+
+
+// load overlay 'ovl' into ovl_area using random reads
+static int ovl_load( uint8_t ovl ) {
+    uint16_t rec;
+    uint8_t *dma = ovl_area;
+
+    if ( !ovl || ovl > ovl_num )
+        return -1;
+    ovl_loaded = 0; // ovl_area is undefined if we fail
+    for ( rec = 0; rec < (ovl_tab[ovl].size + 127) >> 7; ++rec ) {
+        uint16_t r = ovl_tab[ovl].rec + rec;
+        ovl_fcb[33] = r; // random record number r0, r1, r2
+        ovl_fcb[34] = r >> 8;
+        ovl_fcb[35] = 0;
+        bdos( 26, dma ); // BDOS function 26 (F_DMAOFF) - set DMA address
+        if ( bdos( 33, ovl_fcb ) ) { // BDOS function 33 (F_READRAND) - random read
+            bdos( 26, 0x80 );
+            return -1;
+        }
+        dma += 128;
+    }
+    bdos( 26, 0x80 ); // restore default DMA
+    ovl_loaded = ovl;
+    return 0;
+}
+
+
+// call function 'fn' of overlay 'ovl', load the overlay if needed
+int ovl_call( uint8_t ovl, uint8_t fn, void *arg ) {
+    if ( ovl != ovl_loaded && ovl_load( ovl ) ) {
+        gotoyx( PANEL_HEIGHT+1, 1 );
+        erase_eol();
+        printf( " ZMC.OVR missing or invalid " );
+        wait_key_hw();
+        return -1;
+    }
+    return ((int (*)(uint8_t, void *))ovl_area)( fn, arg );
+}
+
+
+// show the TPA gained by the overlays (used by --CONFIG)
+void ovl_info() {
+    uint16_t total = 0;
+    uint8_t ovl;
+    for ( ovl = 1; ovl <= ovl_num; ++ovl )
+        total += ovl_tab[ovl].size;
+    printf( "OVERLAYS: %u, %u bytes in %u byte region\n", ovl_num, total, OVL_SIZE );
+    printf( "TPA gained: %d bytes\n", (int)(total - OVL_SIZE) );
+}
@@ -20,53 +20,58 @@ along with this program. If not, see <https://www.gnu.org/licenses/>.
 #include <string.h>
 #include "zmc.h"
 
-void draw_frame(int x, int y, int w, int h, char *title) {
-    int i;
-    printf("\x1b[%d;%dH+", y, x);
-    for(i=0; i<w-2; i++) putchar('-');
-    putchar('+');
-    printf("\x1b[%d;%dH[ %s ]", y, x + 2, title);
 
-    for(i=1; i<h-1; i++) {
-        printf("\x1b[%d;%dH|", y + i, x);
-        printf("\x1b[%d;%dH|", y + i, x + w - 1);
-    }
+const char *sort_names[SORT_MODES] = { "name", "ext", "size", "date", "dir" };
+
 
-    printf("\x1b[%d;%dH+", y + h - 1, x);
-    for(i=0; i<w-2; i++) putchar('-');
+// horizontal frame line "+-[ title ]---+", title NULL -> no title
+void draw_frame_line(uint8_t x, uint8_t y, uint8_t w, const char *title) {
+    uint8_t i = 1;
+    gotoyx(y, x);
     putchar('+');
+    if ( title ) {
+        printf("-[ %s ]", title);
+        i += strlen(title) + 5;
+    }
+    for( ; i<w-1; i++) putchar('-');
+    putchar('+');
+    cursor_moved(w);
 }
 
-void draw_file_info( Panel *p, int f_idx ) {
+
+// file info of row f_idx, returns the number of characters printed
+uint8_t draw_file_info( Panel *p, int f_idx ) {
+    FileEntry *f = &FILE_AT(p, f_idx);
+
     if (p->active && f_idx == p->current_idx)
         set_invers();
 
     printf("%c%-12s %c%c%c",
-           p->files[f_idx].attrib & 0x80 ? '*' : ' ',
-           p->files[f_idx].cpmname,
-           p->files[f_idx].attrib & 0x01 ? 'R' : ' ',
-           p->files[f_idx].attrib & 0x02 ? 'S' : ' ',
-           p->files[f_idx].attrib & 0x04 ? 'A' : ' '
+           f->attrib & 0x80 ? '*' : ' ',
+           f->cpmname,
+           f->attrib & 0x01 ? 'R' : ' ',
+           f->attrib & 0x02 ? 'S' : ' ',
+           f->attrib & 0x04 ? 'A' : ' '
     );
 
-    if ( p->files[f_idx].extent < 512) // file size < 64K
-        printf( "%6u", p->files[f_idx].extent << 7 );
-    else if ( p->files[f_idx].extent < 7812) // file size < 1E6
-        printf( "%6lu", (uint32_t)p->files[f_idx].extent << 7 );
+    if ( f->extent < 512) // file size < 64K
+        printf( "%6u", f->extent << 7 );
+    else if ( f->extent < 7812) // file size < 1E6
+        printf( "%6lu", (uint32_t)f->extent << 7 );
     else
-        printf( "%5uK", (uint16_t)(p->files[f_idx].extent + 7) >> 3 );
+        printf( "%5uK", (uint16_t)(f->extent + 7) >> 3 );
 
     if ( p->show_date ) {
-        if ( p->files[f_idx].date) { // date and time defined
+        if ( f->date) { // date and time defined
             printf(" %04d%s%02d%s%02d %02X%s%02X",
-                p->files[f_idx].date,
+                f->date,
                 PANEL_WIDTH < 42 ? "" : "-",
-                p->files[f_idx].month,
+                f->month,
                 PANEL_WIDTH < 42 ? "" : "-",
-                p->files[f_idx].day,
-                p->files[f_idx].hour,
+                f->day,
+                f->hour,
                 PANEL_WIDTH < 42 ? "" : ":",
-                p->files[f_idx].minute
+                f->minute
             );
         } else {
         uint8_t w = PANEL_WIDTH < 42 ? 14 : 17;
@@ -76,44 +81,69 @@ void draw_file_info( Panel *p, int f_idx ) {
             putchar( ' ' );
         }
     }
+    if ( p->mode == PM_FIND ) // drive and user of the hit
+        printf( " %c:%-2u", 'A' + HIT_DRIVE(f), HIT_USER(f) );
     if (p->active && f_idx == p->current_idx)
         set_normal();
+    if ( p->mode == PM_FIND )
+        return 28;
+    // 17 name/attrib + 6 size [+ 14 or 17 date]
+    return p->show_date ? ( PANEL_WIDTH < 42 ? 37 : 40 ) : 23;
 }
 
 
 void draw_panel(Panel *p, uint8_t x_offset) {
     uint8_t i;
-    char title[20];
+    char title[40];
     if (p->current_idx < p->scroll_offset) {
         p->scroll_offset = p->current_idx;
     }
     if (p->current_idx >= p->scroll_offset + VISIBLE_ROWS) {
         p->scroll_offset = p->current_idx - (VISIBLE_ROWS - 1);
     }
-    printf("\x1b[m"); // normal
-    sprintf(title, " DISK %c: ", p->drive);
-    draw_frame(x_offset, 1, PANEL_WIDTH, PANEL_HEIGHT, title);
+    ++prof_full;
+    set_normal();
+    if ( p->mode == PM_FIND )
+        sprintf(title, "FIND %s %u", p->pattern, p->num_files);
+    else if ( p->mode == PM_LBR )
+        sprintf(title, "LBR %c:%s %u", p->drive, p->pattern, p->num_files);
+    else {
+        i = sprintf(title, "DISK %c:", p->drive);
+        if ( *p->filter )
+            i += sprintf(title + i, " %s", p->filter);
+        if ( p->total_files > p->num_files ) // windowed, position of the page
+            sprintf(title + i, " %u/%u",
+                    p->win_base + p->scroll_offset + 1, p->total_files);
+        else if ( p->sort != SORT_NAME )
+            sprintf(title + i, " %s", sort_names[p->sort]);
+    }
+    if ( strlen(title) > PANEL_WIDTH - 7 ) // "+-[ " title " ]" "-+"
+        title[PANEL_WIDTH - 7] = '\0';
+    draw_frame_line(x_offset, 1, PANEL_WIDTH, title);
 
+    // the frame sides are drawn with the rows, every row ends in the same
+    // column, so the left panel gets to the next row with CR LF
     for (i = 0; i < VISIBLE_ROWS; i++) {
         int f_idx = i + p->scroll_offset;
-        printf("\x1b[%d;%dH", i + 2, x_offset + 1); // gotoyx
+        uint8_t w = 0;
+        gotoyx(i + 2, x_offset);
+        putchar('|');
         if (f_idx < p->num_files)
-            draw_file_info( p, f_idx );
-        else {
-            uint8_t w = PANEL_WIDTH-2;
-            while ( w-- )
-                putchar( ' ' );
-        }
-            //printf("                                      ");
+            w = draw_file_info( p, f_idx );
+        for ( ; w < PANEL_WIDTH-2; ++w )
+            putchar( ' ' );
+        putchar('|');
+        cursor_moved(PANEL_WIDTH);
     }
+    draw_frame_line(x_offset, PANEL_HEIGHT, PANEL_WIDTH, NULL);
 }
 
 
 void draw_file_line(Panel *p, uint8_t x_offset, uint16_t file_idx) {
     int screen_row = (file_idx - p->scroll_offset) + 2;
     if (file_idx >= p->scroll_offset && file_idx < p->scroll_offset + VISIBLE_ROWS) {
-        printf("\x1b[%d;%dH", screen_row, x_offset + 1); // gotoyx
+        ++prof_part;
+        gotoyx(screen_row, x_offset + 1);
         draw_file_info( p, file_idx );
     }
 }
-
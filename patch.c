@@ -0,0 +1,221 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// PATCH: edit the bytes of the DUMP page in place. The records of the
+// page are read to xfer_buf, a changed record is marked dirty, only the
+// dirty records are written back with random writes (BDOS 34), the file
+// is not copied. After a write the file is closed (partial close, DUMP
+// goes on reading it) and CP/M 3 writes its buffers. The page lines are
+// on rows 1.. as DUMP shows them.
+
+
+#define COL_HEX 7 // "AAAA  " first hex digit
+#define COL_ASC 57 // "AAAA  " 16 x "HH " " |" first char
+#define BUF_SIZE ( XFER_RECS * 128 )
+
+
+static uint16_t first_rec; // record of xfer_buf
+static uint8_t recs; // records in xfer_buf
+static uint8_t dirty[XFER_RECS]; // changed records
+static uint8_t *page; // first byte of the page in xfer_buf
+static uint16_t page_addr; // its file offset, for the dump lines
+
+
+// random read (BDOS 33) or write (BDOS 34) of record r of xfer_buf
+static uint8_t patch_io( uint8_t func, uint8_t r ) {
+    uint8_t err;
+    bdos( 26, xfer_buf + r * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+    *(uint16_t *)( fcb_src + 33 ) = src_base + first_rec + r;
+    fcb_src[35] = 0;
+    err = bdos( func, fcb_src ); // BDOS function 33/34 (F_READRAND/F_WRITERAND)
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    return err;
+}
+
+
+static uint8_t patch_read() {
+    uint8_t r;
+    memset( dirty, 0, sizeof( dirty ) );
+    for ( r = 0; r < recs; ++r )
+        if ( patch_io( 33, r ) ) // BDOS function 33 (F_READRAND) - read random
+            return 0;
+    return 1;
+}
+
+
+// write the dirty records, returns how many, 0xFF on error
+static uint8_t patch_write() {
+    uint8_t r, n = 0;
+    for ( r = 0; r < recs; ++r )
+        if ( dirty[r] ) {
+            if ( patch_io( 34, r ) ) // BDOS function 34 (F_WRITERAND) - write random
+                return 0xFF;
+            dirty[r] = 0;
+            ++n;
+        }
+    if ( n && partial_close( fcb_src ) ) // the directory and the update stamp
+        return 0xFF;
+    if ( n && bdos( 12, NULL ) >= 0x30 )
+        bdos( 48, 0 ); // BDOS function 48 (DRV_FLUSH) - write the buffers of the BDOS
+    return n;
+}
+
+
+static void patch_line( uint8_t line ) {
+    char buf[HEX_LINE_LEN];
+    hex_line( buf, page + line * 16, page_addr + line * 16 );
+    gotoyx( line + 1, 1 );
+    printf( "%s", buf );
+}
+
+
+static void patch_footer( const char *msg ) {
+    gotoyx( PANEL_HEIGHT + 2, 1 );
+    erase_eol();
+    set_invers();
+    printf( " PATCH: %s ", msg );
+    set_normal();
+}
+
+
+static uint8_t dirty_count() {
+    uint8_t r, n = 0;
+    for ( r = 0; r < recs; ++r )
+        n += dirty[r];
+    return n;
+}
+
+
+// edit the lines of the page at file offset start (16 byte aligned),
+// cur_rec is the record at 0x80, updated when it is written
+void patch_page( long start, uint8_t lines, uint16_t cur_rec ) {
+    Panel *p = App.active_panel;
+    uint16_t pos = 0, size;
+    uint8_t hex = 1, lo = 0, k, n;
+    const char *d;
+
+    // CP/M 2.2 ends the program on a write to a R/O file or disk
+    if ( p->mode != PM_DIR || ( FILE_AT( p, p->current_idx ).attrib & 0x01 )
+         || ( bdos_hl( 29, 0 ) & ( 1 << ( p->drive - 'A' ) ) ) ) { // BDOS function 29 (DRV_ROVEC) - R/O drives
+        patch_footer( "READ ONLY (<key>)" );
+        wait_key_hw();
+        return;
+    }
+    // the records of the page that fit into xfer_buf
+    first_rec = start >> 7;
+    page = xfer_buf + ( start & 127 );
+    page_addr = start;
+    if ( lines > ( BUF_SIZE - ( start & 127 ) ) / 16 )
+        lines = ( BUF_SIZE - ( start & 127 ) ) / 16;
+    size = lines * 16;
+    recs = ( ( start & 127 ) + size + 127 ) >> 7;
+    if ( !patch_read() )
+        return;
+
+    patch_footer( "^E^X^S^D move | TAB hex/ASCII | ^W write | <ESC><ESC> exit" );
+    for ( ;; ) {
+        if ( hex )
+            gotoyx( pos / 16 + 1, COL_HEX + 3 * ( pos & 15 ) + lo );
+        else
+            gotoyx( pos / 16 + 1, COL_ASC + ( pos & 15 ) );
+        show_cursor();
+        k = wait_key_hw();
+        hide_cursor();
+        if ( k == ESC ) {
+            k = wait_key_hw();
+            if ( k == ESC )
+                break;
+            if ( k != '[' )
+                continue;
+            k = wait_key_hw(); // cursor keys "<ESC>[A" .. "<ESC>[D"
+            k = k == 'A' ? 'E' - '@' : k == 'B' ? 'X' - '@' : k == 'C' ? 'D' - '@' : k == 'D' ? 'S' - '@' : 0;
+        }
+        if ( k == 'E' - '@' ) { // ^E up
+            if ( pos >= 16 )
+                pos -= 16;
+        } else if ( k == 'X' - '@' ) { // ^X down
+            if ( pos + 16 < size )
+                pos += 16;
+        } else if ( k == 'S' - '@' || k == BS ) { // ^S left
+            if ( hex && lo )
+                lo = 0;
+            else if ( pos ) {
+                --pos;
+                lo = hex;
+            }
+        } else if ( k == 'D' - '@' ) { // ^D right
+            if ( hex && !lo )
+                lo = 1;
+            else if ( pos + 1 < size ) {
+                ++pos;
+                lo = 0;
+            }
+        } else if ( k == TAB ) {
+            hex = !hex;
+            lo = 0;
+        } else if ( k == 'W' - '@' ) { // ^W write
+            patch_footer( patch_write() == 0xFF ? "WRITE ERROR (<key>)" : "WRITTEN (<key>)" );
+            wait_key_hw();
+            patch_footer( "^E^X^S^D move | TAB hex/ASCII | ^W write | <ESC><ESC> exit" );
+        } else if ( hex && k && ( d = strchr( hex_digits, toupper( k ) ) ) ) {
+            n = d - hex_digits;
+            page[pos] = lo ? ( page[pos] & 0xF0 ) | n : ( page[pos] & 0x0F ) | ( n << 4 );
+            dirty[( page + pos - xfer_buf ) >> 7] = 1;
+            patch_line( pos / 16 );
+            if ( lo && pos + 1 < size ) {
+                ++pos;
+                lo = 0;
+            } else
+                lo = 1;
+        } else if ( !hex && k >= SPC && k < RUB ) {
+            page[pos] = k;
+            dirty[( page + pos - xfer_buf ) >> 7] = 1;
+            patch_line( pos / 16 );
+            if ( pos + 1 < size )
+                ++pos;
+        }
+    }
+
+    if ( ( n = dirty_count() ) ) {
+        char msg[40];
+        sprintf( msg, "write %u record(s)? (Y/N)", n );
+        patch_footer( msg );
+        if ( toupper( wait_key_hw() ) == 'Y' ) {
+            if ( patch_write() == 0xFF ) {
+                patch_footer( "WRITE ERROR (<key>)" );
+                wait_key_hw();
+            }
+        } else if ( patch_read() ) { // show the bytes of the file again
+            for ( k = 0; k < lines; ++k )
+                patch_line( k );
+        }
+    }
+    // DUMP goes on with the record at 0x80, as it is in the file now
+    if ( !dirty_count() && cur_rec >= first_rec && cur_rec < first_rec + recs )
+        memcpy( (uint8_t *)0x80, xfer_buf + ( cur_rec - first_rec ) * 128, 128 );
+    gotoyx( PANEL_HEIGHT + 2, 1 );
+    erase_eol();
+}
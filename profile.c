@@ -0,0 +1,201 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// --PROFILE: count what each command costs.
+// prof_hook() is put in front of the BDOS entry (JP at 0005h) like an
+// RSX, so every BDOS call is counted, also the console output of the
+// library. Characters are counted as BDOS 2 and 6 calls, records as
+// BDOS 20/33 (read) and 21/34/40 (write) calls. Counters wrap at 65536.
+
+#define PROF_FUNCS 128
+
+uint16_t prof_calls[PROF_FUNCS]; // calls per BDOS function
+uint16_t prof_bdos; // original BDOS entry address
+uint16_t prof_full = 0; // full panel redraws
+uint16_t prof_part = 0; // partial (single line) redraws
+
+typedef struct {
+    uint16_t bdos;  // BDOS calls
+    uint16_t rd;    // records read
+    uint16_t wr;    // records written
+    uint16_t chars; // console characters
+    uint16_t full;  // full panel redraws
+    uint16_t part;  // line redraws
+} prof_count;
+
+static prof_count prof_mark; // counters at start of command
+static uint32_t prof_t0; // seconds at start of command
+static uint32_t prof_start_t; // seconds at program start
+static uint16_t prof_cmds = 0; // number of commands
+static uint8_t prof_clock_ok = 0; // CP/M 3 clock available
+
+
+void prof_hook() {
+#asm
+    ; BDOS entry, C = function, DE = parameter, keep all of them
+    push    hl
+    push    bc
+    bit     7, c
+    jr      nz, prof_skip   ; function >= PROF_FUNCS
+    ld      b, 0
+    ld      hl, _prof_calls
+    add     hl, bc
+    add     hl, bc          ; &prof_calls[c]
+    inc     (hl)
+    jr      nz, prof_skip
+    inc     hl
+    inc     (hl)
+prof_skip:
+    pop     bc
+    ld      hl, (_prof_bdos)
+    ex      (sp), hl        ; restore HL, BDOS addr on stack
+    ret                     ; continue in BDOS
+#endasm
+}
+
+
+// BCD byte -> binary
+static uint8_t bcd( uint8_t b ) {
+    return (b >> 4) * 10 + (b & 0x0F);
+}
+
+
+// seconds from the CP/M 3 clock, 0 without clock
+static uint32_t prof_clock() {
+    uint8_t dat[4]; // day (word), hour, minute in BCD
+    uint8_t sec;
+    if ( !prof_clock_ok )
+        return 0;
+    sec = bdos( 105, dat ); // BDOS function 105 (T_GET) - get date and time
+    return ( *(uint16_t *)dat * 86400L )
+        + bcd( dat[2] ) * 3600L + bcd( dat[3] ) * 60 + bcd( sec );
+}
+
+
+static void prof_sum( prof_count *c ) {
+    uint8_t f;
+    c->bdos = 0;
+    for ( f = 0; f < PROF_FUNCS; ++f )
+        c->bdos += prof_calls[f];
+    c->rd = prof_calls[20] + prof_calls[33];
+    c->wr = prof_calls[21] + prof_calls[34] + prof_calls[40];
+    c->chars = prof_calls[2] + prof_calls[6];
+    c->full = prof_full;
+    c->part = prof_part;
+}
+
+
+// install the BDOS hook
+void prof_start() {
+    prof_clock_ok = bdos( 12, NULL ) >= 0x30; // CP/M 3 has a clock
+    memset( prof_calls, 0, sizeof( prof_calls ) );
+    prof_bdos = *(uint16_t *)6;
+    *(uint16_t *)6 = (uint16_t)prof_hook;
+    prof_start_t = prof_clock();
+}
+
+
+// remember the counters before a command
+void prof_begin() {
+    prof_sum( &prof_mark );
+    prof_t0 = prof_clock();
+}
+
+
+// show the cost of the last command in the function key line
+void prof_end() {
+    prof_count c;
+    uint32_t t = prof_clock();
+    prof_sum( &c );
+    ++prof_cmds;
+    gotoyx( PANEL_HEIGHT+2, 1 );
+    erase_eol();
+    set_invers();
+    printf( " BDOS:%u RD:%u WR:%u CHR:%u DRAW:%u/%u",
+            c.bdos - prof_mark.bdos - (prof_clock_ok ? 2 : 0), // w/o T_GET
+            c.rd - prof_mark.rd, c.wr - prof_mark.wr,
+            c.chars - prof_mark.chars,
+            c.full - prof_mark.full, c.part - prof_mark.part );
+    if ( prof_clock_ok )
+        printf( " T:%lus", t - prof_t0 );
+    putchar( ' ' );
+    set_normal();
+}
+
+
+// write one line to the record in the default DMA buffer
+static uint8_t prf_pos; // fill level of the record at 0x80
+
+static void prf_puts( uint8_t *fcb, const char *s ) {
+    while ( *s ) {
+        *(uint8_t *)(0x80 + prf_pos++) = *s++;
+        if ( prf_pos == 128 ) {
+            bdos( 21, fcb ); // BDOS function 21 (F_WRITE) - write next record
+            prf_pos = 0;
+        }
+    }
+}
+
+
+// remove the BDOS hook and write the totals to ZMC.PRF
+void prof_stop() {
+    uint8_t fcb[36];
+    char line[48];
+    prof_count c;
+    uint8_t f;
+    uint32_t t = prof_clock();
+
+    *(uint16_t *)6 = prof_bdos;
+    prof_sum( &c );
+
+    memset( fcb, 0, sizeof( fcb ) );
+    *fcb = home_drive + 1;
+    memcpy( fcb+1, "ZMC     PRF", 11 );
+    bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file
+    if ( bdos( 22, fcb ) == 255 ) // BDOS function 22 (F_MAKE) - create file
+        return;
+    prf_pos = 0;
+    sprintf( line, "ZMC PROFILE\r\nCOMMANDS %u\r\n", prof_cmds );
+    prf_puts( fcb, line );
+    sprintf( line, "BDOS %u\r\nREAD %u\r\nWRITE %u\r\n", c.bdos, c.rd, c.wr );
+    prf_puts( fcb, line );
+    sprintf( line, "CHARS %u\r\nFULL %u\r\nLINE %u\r\n", c.chars, c.full, c.part );
+    prf_puts( fcb, line );
+    if ( prof_clock_ok ) {
+        sprintf( line, "SECONDS %lu\r\n", t - prof_start_t );
+        prf_puts( fcb, line );
+    }
+    for ( f = 0; f < PROF_FUNCS; ++f )
+        if ( prof_calls[f] ) {
+            sprintf( line, "F%u %u\r\n", f, prof_calls[f] );
+            prf_puts( fcb, line );
+        }
+    // fill the last record with EOF
+    do
+        *(uint8_t *)(0x80 + prf_pos++) = 0x1A;
+    while ( prf_pos < 128 );
+    bdos( 21, fcb ); // BDOS function 21 (F_WRITE) - write next record
+    bdos( 16, fcb ); // BDOS function 16 (F_CLOSE) - close file
+}
@@ -0,0 +1,227 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// QUICK VIEW: the other panel shows the start of the file under the
+// cursor, as text or as hex dump, and follows the cursor. The first
+// records of the files shown are kept in an LRU cache in the file
+// storage of the other panel, going back to a file reads no record.
+// Only the inside of the other panel is drawn again. The other panel is
+// read again when QUICK VIEW ends.
+
+
+#define QV_RECS  8 // records per file, more than a panel of text
+#define QV_SLOTS 16
+
+typedef struct {
+    char name[FILENAME_LEN];
+    char drive;
+    uint8_t mode; // PM_DIR or PM_LBR
+    char lib[FILENAME_LEN]; // PM_LBR: the library
+    uint16_t dirpos; // PM_LBR: first record of the member
+    uint16_t used; // LRU stamp, 0 = free
+    uint8_t recs; // records read
+    uint8_t data[QV_RECS * 128];
+} qv_slot;
+
+uint8_t qview = 0; // the other panel shows the current file
+
+static Panel *qv_panel; // the other panel
+static char qv_name[FILENAME_LEN]; // its current file
+static qv_slot *slots;
+static uint8_t n_slots;
+static uint16_t stamp;
+static qv_slot *shown; // in the panel now
+
+
+// a disk file and a library member of the same name are different
+static uint8_t slot_is( qv_slot *s, Panel *p, FileEntry *f ) {
+    return s->used && s->drive == p->drive && s->mode == p->mode && !strcmp( s->name, f->cpmname )
+           && ( p->mode != PM_LBR || ( s->dirpos == f->dirpos && !strcmp( s->lib, p->pattern ) ) );
+}
+
+
+// the slot of file f of panel p, the least recently used one is read
+// again on a miss, NULL if the file can not be read
+static qv_slot *qv_get( Panel *p, FileEntry *f ) {
+    qv_slot *s, *lru = slots;
+    uint8_t i;
+
+    if ( !++stamp ) { // the stamps start again, the order is lost
+        for ( i = 0; i < n_slots; ++i )
+            slots[i].used = !!slots[i].used;
+        stamp = 2;
+    }
+    for ( i = 0, s = slots; i < n_slots; ++i, ++s ) {
+        if ( slot_is( s, p, f ) ) {
+            s->used = stamp;
+            return s;
+        }
+        if ( s->used < lru->used )
+            lru = s;
+    }
+    s = lru;
+    s->used = 0;
+    if ( open_src( p, f ) == 255 )
+        return NULL;
+    for ( s->recs = 0; s->recs < QV_RECS && s->recs < src_recs; ++s->recs ) {
+        bdos( 26, s->data + s->recs * 128 ); // BDOS function 26 (F_DMAOFF) - set DMA address
+        if ( bdos( 20, fcb_src ) ) // BDOS function 20 (F_READ) - read next record
+            break;
+    }
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    strcpy( s->name, f->cpmname );
+    s->drive = p->drive;
+    s->mode = p->mode;
+    strcpy( s->lib, p->mode == PM_LBR ? p->pattern : "" );
+    s->dirpos = f->dirpos;
+    s->used = stamp;
+    return s;
+}
+
+
+// text: control characters other than CR LF TAB FF ^Z in the first record
+static uint8_t is_text( qv_slot *s ) {
+    uint8_t i, c;
+    for ( i = 0; i < 128 && i < s->recs * 128; ++i ) {
+        c = s->data[i] & 0x7F; // WordStar: bit 7 set
+        if ( c == 0x1A )
+            break;
+        if ( c < SPC && c != CR && c != LF && c != TAB && c != 0x0C )
+            return 0;
+    }
+    return 1;
+}
+
+
+// the rows of the panel from s, NULL: empty
+static void qv_rows( uint8_t x, qv_slot *s ) {
+    uint16_t size = s ? s->recs * 128 : 0, pos = 0;
+    uint8_t w = PANEL_WIDTH - 2, per = ( w - 5 ) / 4; // hex: "AAAA " per x "HH " and char
+    uint8_t text = s && is_text( s ), row, col, c, i;
+
+    for ( row = 0; row < VISIBLE_ROWS; ++row ) {
+        gotoyx( row + 2, x );
+        putchar( '|' );
+        col = 0;
+        if ( text ) {
+            // one line, cut at the panel width
+            for ( ; pos < size && ( c = s->data[pos] & 0x7F ) != 0x1A; ++pos ) {
+                if ( c == LF ) {
+                    ++pos;
+                    break;
+                }
+                if ( c == TAB ) {
+                    if ( col < w )
+                        do
+                            putchar( ' ' );
+                        while ( ++col < w && col & 7 );
+                } else if ( c >= SPC && col < w ) {
+                    putchar( c );
+                    ++col;
+                }
+            }
+        } else if ( pos < size ) {
+            printf( "%04X ", pos );
+            for ( i = 0; i < per; ++i )
+                if ( pos + i < size )
+                    printf( "%02X ", s->data[pos + i] );
+                else
+                    printf( "   " );
+            col = 5 + per * 3;
+            for ( i = 0; i < per && pos < size; ++i, ++pos, ++col ) {
+                c = s->data[pos];
+                putchar( c >= SPC && c < RUB ? c : '.' );
+            }
+        }
+        for ( ; col < w; ++col )
+            putchar( ' ' );
+        putchar( '|' );
+        cursor_moved( PANEL_WIDTH );
+    }
+}
+
+
+// draw the other panel with the current file of the active panel
+void qview_draw( void ) {
+    Panel *p = App.active_panel;
+    uint8_t x = qv_panel == &App.left ? 1 : PANEL_WIDTH + 1;
+    char title[FILENAME_LEN + 6];
+    FileEntry *f;
+
+    shown = NULL;
+    set_normal();
+    if ( p->num_files && p->mode != PM_FIND ) {
+        f = &FILE_AT( p, p->current_idx );
+        sprintf( title, "VIEW %s", f->cpmname );
+        shown = qv_get( p, f );
+    } else
+        strcpy( title, "VIEW" );
+    draw_frame_line( x, 1, PANEL_WIDTH, title );
+    qv_rows( x, shown );
+    draw_frame_line( x, PANEL_HEIGHT, PANEL_WIDTH, NULL );
+}
+
+
+// after a key: draw the other panel if the current file changed
+void qview_update( void ) {
+    Panel *p = App.active_panel;
+    if ( !qview )
+        return;
+    if ( p->num_files && p->mode != PM_FIND ) {
+        if ( shown && slot_is( shown, p, &FILE_AT( p, p->current_idx ) ) )
+            return;
+    } else if ( !shown )
+        return;
+    qview_draw();
+}
+
+
+// QUICK VIEW in the other panel, its file storage is the cache
+void qview_open( void ) {
+    uint8_t i;
+    qv_panel = App.active_panel == &App.left ? &App.right : &App.left;
+    strcpy( qv_name, qv_panel->num_files ? FILE_AT( qv_panel, qv_panel->current_idx ).cpmname : "" );
+    dcache_claim( qv_panel );
+    slots = (qv_slot *)qv_panel->files;
+    n_slots = MAX_FILES * ( sizeof( FileEntry ) + sizeof( uint16_t ) ) / sizeof( qv_slot ) < QV_SLOTS
+              ? MAX_FILES * ( sizeof( FileEntry ) + sizeof( uint16_t ) ) / sizeof( qv_slot ) : QV_SLOTS;
+    if ( !n_slots )
+        return;
+    for ( i = 0; i < n_slots; ++i )
+        slots[i].used = 0;
+    stamp = 1;
+    qview = 1;
+    qview_draw();
+}
+
+
+// back to the files of the other panel
+void qview_close( void ) {
+    if ( !qview )
+        return;
+    qview = 0;
+    reload_panel( qv_panel, qv_name );
+    refresh_ui( PAN_OTHER );
+}
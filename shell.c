@@ -0,0 +1,255 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// "!STAT B:" runs a CP/M command and comes back with "ZMC --RESUME"
+// (ZMC80X24 for that build, --PROFILE is passed on).
+// The panels are saved to $ZMC.$$$ on the drive ZMC was started from:
+//   record 0..   struct snapshot (App and the drive fingerprints)
+//   then         files and order of the left, then of the right panel
+// every part starts on a new record. On return only the drives whose
+// fingerprint changed are read again, the others keep cursor and tags.
+
+
+#define SNAP_MAGIC "ZMC1"
+
+struct snapshot {
+    char magic[4];
+    uint16_t max_files; // same heap layout
+    uint16_t drives; // bit n: fp[n] is valid
+    uint16_t fp[16]; // disk_print() per drive
+    AppState app;
+};
+
+
+// fingerprint of the allocation of drive drv: checksum of the allocation
+// vector (CP/M 2.2) or the free space (CP/M 3, the vector may be banked).
+// A file rewritten in the same blocks or renamed is not noticed.
+uint16_t disk_print( uint8_t drv ) {
+    uint8_t *alv;
+    uint16_t n, sum = 0;
+
+    bdos( 14, drv ); // BDOS function 14 (DRV_SET) - select disk
+    if ( bdos( 12, NULL ) >= 0x30 ) {
+        bdos( 46, drv ); // BDOS function 46 (DRV_SPACE) - free records at DMA
+        return *(uint16_t *)0x80 ^ ( *(uint8_t *)0x82 << 8 );
+    }
+    // bytes of the vector for the blocks 0..dsm
+    n = ( *(uint16_t *)( bdos_hl( 31, 0 ) + 5 ) >> 3 ) + 1; // BDOS function 31 (DRV_DPB)
+    alv = (uint8_t *)bdos_hl( 27, 0 ); // BDOS function 27 (DRV_ALLOCVEC)
+    while ( n-- )
+        sum = ( ( sum << 1 ) | ( sum >> 15 ) ) + *alv++;
+    return sum;
+}
+
+
+// FCB of $ZMC.$$$ on the home drive
+static void snap_fcb( uint8_t *fcb ) {
+    memset( fcb, 0, 36 );
+    *fcb = home_drive + 1;
+    memcpy( fcb+1, "$ZMC    $$$", 11 );
+}
+
+
+// read (func 20) or write (func 21) len bytes at data as records,
+// the last part goes through the default DMA buffer, 0 = OK
+static uint8_t snap_io( uint8_t *fcb, void *data, uint16_t len, uint8_t func ) {
+    uint8_t *d = data;
+    uint8_t err = 0;
+
+    for ( ; len >= 128 && !err; d += 128, len -= 128 ) {
+        bdos( 26, d ); // BDOS function 26 (F_DMAOFF) - set DMA address
+        err = bdos( func, fcb ); // BDOS function 20 (F_READ) / 21 (F_WRITE)
+    }
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    if ( len && !err ) {
+        if ( func == 21 )
+            memcpy( (void *)0x80, d, len );
+        err = bdos( func, fcb );
+        if ( func == 20 )
+            memcpy( d, (void *)0x80, len );
+    }
+    return err;
+}
+
+
+// the file entries and their display order of panel p
+static uint8_t snap_panel( uint8_t *fcb, Panel *p, uint8_t func ) {
+    return snap_io( fcb, p->files, p->num_files * sizeof( FileEntry ), func )
+        || snap_io( fcb, p->order, p->num_files * sizeof( uint16_t ), func );
+}
+
+
+// CP/M 2.2: add a command to A:$$$.SUB, the CCP runs the last record first
+static void submit_line( uint8_t *fcb, const char *s ) {
+    uint8_t *rec = (uint8_t *)0x80;
+    uint8_t len = strlen( s );
+
+    memset( rec, 0, 128 );
+    *rec = len;
+    memcpy( rec + 1, s, len );
+    bdos( 34, fcb ); // BDOS function 34 (F_WRITERAND) - write random
+    if ( !++fcb[33] ) // next record
+        ++fcb[34];
+}
+
+
+static void shell_error( const char *msg ) {
+    gotoyx( SCREEN_HEIGHT-1, 1 );
+    erase_eol();
+    set_invers();
+    printf( " %s ", msg );
+    set_normal();
+    wait_key_hw();
+}
+
+
+// save the panels and run cmd, does not return if the command is started
+void shell_out( const char *cmd ) {
+    struct snapshot snap;
+    uint8_t fcb[36];
+    char resume[16];
+    char again[32];
+    Panel *p;
+    uint8_t drv, user;
+    uint8_t cpm3 = bdos( 12, NULL ) >= 0x30;
+
+    while ( *cmd == ' ' )
+        ++cmd;
+    if ( !*cmd )
+        return;
+    sprintf( again, "%s --RESUME%s", ZMC_NAME, PROFILE ? " --PROFILE" : "" );
+    // CP/M 3: one chain line "cmd!A:!ZMC --RESUME" in the DMA buffer
+    if ( strlen( cmd ) + strlen( again ) > 122 ) {
+        shell_error( "COMMAND TOO LONG" );
+        return;
+    }
+
+    memset( &snap, 0, sizeof( snap ) );
+    memcpy( snap.magic, SNAP_MAGIC, 4 );
+    snap.max_files = MAX_FILES;
+    memcpy( &snap.app, &App, sizeof( AppState ) );
+    for ( p = &App.left; p; p = p == &App.left ? &App.right : NULL ) {
+        drv = p->drive - 'A';
+        if ( p->mode == PM_DIR && !( snap.drives & ( 1 << drv ) ) ) {
+            snap.fp[drv] = disk_print( drv );
+            snap.drives |= 1 << drv;
+        }
+    }
+
+    snap_fcb( fcb );
+    bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file
+    if ( bdos( 22, fcb ) == 255 // BDOS function 22 (F_MAKE) - create file
+        || snap_io( fcb, &snap, sizeof( snap ), 21 )
+        || snap_panel( fcb, &App.left, 21 ) || snap_panel( fcb, &App.right, 21 )
+        || bdos( 16, fcb ) == 255 ) { // BDOS function 16 (F_CLOSE) - close file
+        bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file
+        shell_error( "CANNOT WRITE $ZMC.$$$" );
+        refresh_ui( PAN_BOTH );
+        return;
+    }
+
+    if ( PROFILE )
+        prof_stop(); // write ZMC.PRF
+    set_normal();
+    clrscr();
+    show_cursor();
+
+    // the command runs on the drive of the active panel
+    drv = App.active_panel->drive - 'A';
+    user = bdos( 32, 0xFF ); // BDOS function 32 (F_USERNUM) - get user number
+    sprintf( resume, "%c:", 'A' + home_drive );
+    if ( cpm3 ) {
+        bdos( 14, drv ); // BDOS function 14 (DRV_SET) - select disk
+        sprintf( (char *)0x80, "%s!%s!%s", cmd, resume, again );
+        bdos( 47, 0xFF ); // BDOS function 47 (P_CHAIN) - chain, same drive and user
+    } else {
+        // append to a running SUBMIT job, its rest runs after ZMC
+        memset( fcb, 0, 36 );
+        fcb[0] = 1; // A:
+        memcpy( fcb+1, "$$$     SUB", 11 );
+        if ( bdos( 15, fcb ) == 255 ) // BDOS function 15 (F_OPEN) - open file
+            bdos( 22, fcb ); // BDOS function 22 (F_MAKE) - create file
+        bdos( 35, fcb ); // BDOS function 35 (F_SIZE) - random record = file size
+        submit_line( fcb, again );
+        submit_line( fcb, resume );
+        submit_line( fcb, cmd );
+        bdos( 16, fcb ); // BDOS function 16 (F_CLOSE) - close file
+        *(uint8_t *)4 = ( user << 4 ) | drv; // CCP drive and user
+        bdos( 0, 0 ); // BDOS function 0 (P_TERMCPM) - warm boot, runs $$$.SUB
+    }
+}
+
+
+// "ZMC --RESUME": restore the panels from $ZMC.$$$, read the drives
+// that changed since, returns 0 if there is no usable snapshot
+uint8_t shell_resume() {
+    struct snapshot snap;
+    uint8_t fcb[36];
+    char name[FILENAME_LEN];
+    Panel *p;
+    uint16_t checked = 0, changed = 0;
+    uint8_t drv, ok;
+
+    snap_fcb( fcb );
+    if ( bdos( 15, fcb ) == 255 ) // BDOS function 15 (F_OPEN) - open file
+        return 0;
+    ok = !snap_io( fcb, &snap, sizeof( snap ), 20 )
+        && !memcmp( snap.magic, SNAP_MAGIC, 4 )
+        && snap.max_files == MAX_FILES;
+    if ( ok ) {
+        // keep the heap pointers of this run
+        snap.app.left.files = App.left.files;
+        snap.app.left.order = App.left.order;
+        snap.app.right.files = App.right.files;
+        snap.app.right.order = App.right.order;
+        ok = !snap_panel( fcb, &snap.app.left, 20 )
+            && !snap_panel( fcb, &snap.app.right, 20 );
+    }
+    bdos( 19, fcb ); // BDOS function 19 (F_DELETE) - delete file, used once
+    if ( !ok )
+        return 0;
+
+    memcpy( &App, &snap.app, sizeof( AppState ) );
+    App.active_panel = App.left.active ? &App.left : &App.right;
+    for ( p = &App.left; p; p = p == &App.left ? &App.right : NULL ) {
+        if ( p->mode != PM_DIR ) // FIND hits are kept
+            continue;
+        drv = p->drive - 'A';
+        if ( !( checked & ( 1 << drv ) ) ) {
+            checked |= 1 << drv;
+            if ( !( snap.drives & ( 1 << drv ) ) || disk_print( drv ) != snap.fp[drv] )
+                changed |= 1 << drv;
+        }
+        if ( changed & ( 1 << drv ) ) { // read again, the cursor stays on the file
+            *name = '\0';
+            if ( p->num_files )
+                strcpy( name, FILE_AT( p, p->current_idx ).cpmname );
+            load_directory( p );
+            if ( *name )
+                goto_file( p, name );
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,249 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+// Decoders for the viewer, the file is read as it is shown:
+//   SQ     .?Q?  Huffman tree in the header, bits LSB first
+//   Crunch .?Z?  v2 LZW, 9..12 bit codes MSB first, 4096 entries
+// Both code the bytes after a run length encoding: 0x90 n repeats the
+// last byte up to n times in all, 0x90 0 is 0x90 itself.
+// The compressed records are read with fcb_src to the default DMA
+// buffer, the tables are in the memory given to dec_open().
+
+
+#define DLE 0x90
+
+#define SQ_MAGIC 0xFF76
+#define SQ_SPEOF 256 // end of file value
+#define SQ_NODES 257
+
+#define CR_MAGIC 0xFE76
+#define CR_EOF   0x100
+#define CR_RESET 0x101 // adaptive reset of the table
+#define CR_NULL  0x102
+#define CR_SPARE 0x103
+#define CR_FIRST 0x104 // first free entry
+#define CR_TABLE 4096
+#define CR_NONE  0xFFFF
+#define CR_MEM   ( CR_TABLE * 4 ) // pred, suffix and stack
+
+
+static uint8_t dec_type = DEC_RAW;
+static uint8_t *in_ptr; // next byte in the record at 0x80
+static uint16_t in_left; // records left, library member
+static uint32_t bits; // bit buffer
+static uint8_t nbits;
+
+static int16_t rle_last; // last byte for 0x90 n
+static uint8_t rle_rep; // repeats left
+
+static int16_t *sq_nodes; // children, < 0: -(value + 1)
+static uint16_t sq_count;
+
+static uint16_t *cr_pred; // prefix code of the entry
+static uint8_t *cr_suffix; // last byte of the entry
+static uint8_t *cr_stack; // the bytes of a string, last first
+static uint16_t cr_sp, cr_entry, cr_old;
+static uint8_t cr_len; // bits per code
+static uint8_t cr_fin; // first byte of the last string
+
+
+// next byte of the compressed file, -1 at the end
+static int16_t get_byte() {
+    if ( in_ptr == (uint8_t *)0x100 ) {
+        if ( !in_left || bdos( 20, fcb_src ) ) // BDOS function 20 (F_READ) - read next record
+            return -1;
+        --in_left;
+        in_ptr = (uint8_t *)0x80;
+    }
+    return *in_ptr++;
+}
+
+
+static uint16_t get_word() {
+    uint16_t w = get_byte() & 0xFF;
+    return w | ( ( get_byte() & 0xFF ) << 8 );
+}
+
+
+// SQ: walk down the tree, one bit per node
+static int16_t sq_value() {
+    int16_t i = 0, c;
+    if ( !sq_count ) // empty file
+        return -1;
+    do {
+        if ( !nbits ) {
+            if ( ( c = get_byte() ) < 0 )
+                return -1;
+            bits = c;
+            nbits = 8;
+        }
+        i = sq_nodes[( i << 1 ) + ( bits & 1 )];
+        bits >>= 1;
+        --nbits;
+    } while ( i >= 0 );
+    i = -( i + 1 );
+    return i == SQ_SPEOF ? -1 : i;
+}
+
+
+static int16_t cr_code() {
+    int16_t c;
+    while ( nbits < cr_len ) {
+        if ( ( c = get_byte() ) < 0 )
+            return -1;
+        bits = ( bits << 8 ) | c;
+        nbits += 8;
+    }
+    nbits -= cr_len;
+    return ( bits >> nbits ) & ( ( 1 << cr_len ) - 1 );
+}
+
+
+// Crunch: the first byte of the next string, the others are on the stack
+static int16_t cr_value() {
+    int16_t code, in;
+
+    if ( cr_sp )
+        return cr_stack[--cr_sp];
+    for ( ;; ) {
+        if ( ( code = cr_code() ) < 0 || code == CR_EOF )
+            return -1;
+        if ( code == CR_RESET ) {
+            cr_entry = CR_FIRST;
+            cr_len = 9;
+            cr_old = CR_NONE;
+        } else if ( code != CR_NULL && code != CR_SPARE )
+            break;
+    }
+    in = code;
+    if ( code >= cr_entry ) { // the entry to be made: last string + its first byte
+        if ( code > cr_entry || cr_old == CR_NONE )
+            return -1;
+        cr_stack[cr_sp++] = cr_fin;
+        code = cr_old;
+    }
+    while ( code > 0xFF ) {
+        cr_stack[cr_sp++] = cr_suffix[code];
+        code = cr_pred[code];
+    }
+    cr_fin = code;
+    if ( cr_old != CR_NONE && cr_entry < CR_TABLE ) {
+        cr_pred[cr_entry] = cr_old;
+        cr_suffix[cr_entry] = cr_fin;
+        // the next code may be the next entry
+        if ( ++cr_entry == ( 1 << cr_len ) && cr_len < 12 )
+            ++cr_len;
+    }
+    cr_old = in;
+    return cr_fin;
+}
+
+
+// next decoded byte, -1 at the end
+static int16_t dec_byte() {
+    int16_t c;
+    for ( ;; ) {
+        if ( rle_rep ) {
+            --rle_rep;
+            return rle_last;
+        }
+        c = dec_type == DEC_SQ ? sq_value() : cr_value();
+        if ( c != DLE )
+            return rle_last = c;
+        c = dec_type == DEC_SQ ? sq_value() : cr_value();
+        if ( c <= 0 )
+            return c ? -1 : DLE;
+        rle_rep = c - 1; // the last byte is out already
+    }
+}
+
+
+// file opened with open_src(): read the header of a squeezed or crunched
+// file, mem holds the tables. DEC_RAW if it is not compressed, the
+// size is too small or the format unknown (crunch v1), the first record
+// is read then.
+uint8_t dec_open( uint8_t *mem, uint16_t size ) {
+    uint16_t magic, i;
+    int16_t c;
+
+    in_left = src_recs;
+    in_ptr = (uint8_t *)0x100;
+    nbits = 0;
+    bits = 0;
+    rle_last = 0;
+    rle_rep = 0;
+    dec_type = DEC_RAW;
+
+    magic = get_word();
+    if ( magic == SQ_MAGIC ) {
+        get_word(); // checksum
+        while ( ( c = get_byte() ) > 0 ) // original name
+            ;
+        sq_count = get_word();
+        if ( c < 0 || sq_count > SQ_NODES || sq_count * 4 > size )
+            return DEC_RAW;
+        sq_nodes = (int16_t *)mem;
+        for ( i = 0; i < sq_count * 2; ++i ) {
+            c = get_word();
+            if ( c >= (int16_t)sq_count || c < -( SQ_SPEOF + 1 ) )
+                return DEC_RAW; // no tree
+            sq_nodes[i] = c;
+        }
+        dec_type = DEC_SQ;
+    } else if ( magic == CR_MAGIC && size >= CR_MEM ) {
+        while ( ( c = get_byte() ) > 0 ) // original name and comment
+            ;
+        get_byte(); // reference revision
+        c = get_byte(); // significant revision, v1 has no variable codes
+        get_word(); // error detection, spare
+        if ( c < 0x20 )
+            return DEC_RAW;
+        cr_pred = (uint16_t *)mem;
+        cr_suffix = mem + CR_TABLE * 2;
+        cr_stack = mem + CR_TABLE * 3;
+        cr_sp = 0;
+        cr_entry = CR_FIRST;
+        cr_len = 9;
+        cr_old = CR_NONE;
+        dec_type = DEC_CRUNCH;
+    }
+    return dec_type;
+}
+
+
+// up to max decoded bytes to buf, 0 at the end
+uint16_t dec_read( uint8_t *buf, uint16_t max ) {
+    uint16_t n = 0;
+    int16_t c;
+    if ( dec_type == DEC_RAW )
+        return 0;
+    while ( n < max ) {
+        if ( ( c = dec_byte() ) < 0 ) {
+            dec_type = DEC_RAW; // at the end
+            break;
+        }
+        buf[n++] = c;
+    }
+    return n;
+}
@@ -0,0 +1,454 @@
+/*
+Z80 Management Commander (ZMC)
+Copyright (C) 2026 Volney Torres
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cpm.h>
+
+#include "zmc.h"
+
+
+#ifdef OVL_MODULE
+// overlay entry point, must be the first function of the overlay
+int ovl_main( uint8_t fn, void *arg ) {
+    if ( fn == 0 )
+        view_file();
+    else if ( fn == 1 )
+        dump_file();
+    return 0;
+}
+#endif
+
+
+void show_header() {
+    if ( !BATCH ) // command line mode writes to the console as is
+        clrscr(); // erase, home, hide cursor
+}
+
+
+void show_footer( const char *action, const char *file_name ) {
+    set_invers();
+    printf(" %s: %s (<SPACE>: more | F: find | N: next | <ESC>: exit) ", action, file_name);
+    set_normal();
+}
+
+
+// Search: Boyer-Moore-Horspool over the bytes after the shown page,
+// read in parts of up to XFER_RECS-1 records to xfer_buf. The first
+// record of xfer_buf keeps the last bytes of the previous part for hits
+// across the part boundary. The text is case-insensitive.
+// Files are read with sequential reads, the view is positioned at the
+// hit with a random read. A compressed file is decoded while searching,
+// the decoded page starts in xfer_buf, a failed search ends there.
+#define SEARCH_MAX 32 // bytes of the pattern
+
+#if XFER_RECS < 2
+#error "the search needs XFER_RECS >= 2"
+#endif
+
+#define BUF_END ( xfer_buf + XFER_RECS * 128 )
+
+static uint8_t search_pat[SEARCH_MAX]; // text: upper case
+static uint8_t search_len = 0;
+static uint8_t search_text; // case-insensitive
+static long search_hit; // file offset of the last hit
+static uint8_t *hit_ptr; // the hit in xfer_buf
+static uint8_t *buf_start; // valid bytes in xfer_buf from here
+static uint8_t *buf_end; // and up to here
+
+static uint16_t view_rec; // records read
+static uint8_t decoding; // DEC_SQ or DEC_CRUNCH, 0 = file as it is
+static uint8_t src_end; // no more data
+
+
+// random read of record r (of the member) to buf, the next sequential
+// read gets r again
+static uint8_t read_record( uint16_t r, uint8_t *buf ) {
+    uint8_t err;
+    if ( r >= src_recs ) // end of the library member
+        return 1;
+    bdos( 26, buf ); // BDOS function 26 (F_DMAOFF) - set DMA address
+    *(uint16_t *)( fcb_src + 33 ) = src_base + r;
+    fcb_src[35] = 0;
+    err = bdos( 33, fcb_src ); // BDOS function 33 (F_READRAND) - read random
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    return err;
+}
+
+
+// the next sequential read starts at file offset off,
+// returns the bytes to skip in that record
+static uint8_t seek_offset( long off ) {
+    view_rec = off >> 7;
+    read_record( view_rec, xfer_buf );
+    return off & 127;
+}
+
+
+// append the next records or decoded bytes to xfer_buf, returns the end
+static uint8_t *search_fill( uint8_t *end ) {
+    uint16_t n;
+    if ( decoding ) {
+        n = dec_read( end, BUF_END - end );
+        src_end = end + n < BUF_END;
+        return end + n;
+    }
+    for ( ; end + 128 <= BUF_END; end += 128 ) {
+        bdos( 26, end ); // BDOS function 26 (F_DMAOFF) - set DMA address
+        if ( view_rec >= src_recs || bdos( 20, fcb_src ) ) { // BDOS function 20 (F_READ) - read next record
+            src_end = 1;
+            break;
+        }
+        ++view_rec;
+    }
+    bdos( 26, 0x80 ); // BDOS function 26 (F_DMAOFF) - default DMA
+    return end;
+}
+
+
+// search from rest on (rest_len bytes not shown yet, at file offset pos),
+// returns the hit in xfer_buf and its offset in search_hit, or NULL
+static uint8_t *file_search( const uint8_t *rest, uint16_t rest_len, long pos ) {
+    uint8_t shift[256]; // bad character shift
+    uint8_t *data = xfer_buf + 128;
+    uint8_t *s = data, *end;
+    uint8_t m = search_len;
+    uint8_t carry, k, c;
+
+    memset( shift, m, sizeof( shift ) );
+    for ( k = 0; k < m - 1; ++k ) {
+        shift[search_pat[k]] = m - 1 - k;
+        if ( search_text )
+            shift[tolower( search_pat[k] )] = m - 1 - k;
+    }
+    memmove( data, rest, rest_len ); // may be in xfer_buf already
+    end = data + rest_len;
+    buf_start = data;
+    src_end = 0;
+    for ( ;; ) { // pos is the offset of data
+        end = search_fill( end );
+        while ( s + m <= end ) {
+            c = s[m - 1];
+            if ( ( search_text ? toupper( c ) : c ) == search_pat[m - 1] ) {
+                for ( k = 0; k < m - 1; ++k ) {
+                    c = search_text ? toupper( s[k] ) : s[k];
+                    if ( c != search_pat[k] )
+                        break;
+                }
+                if ( k == m - 1 ) {
+                    search_hit = pos + ( s - data );
+                    buf_end = end;
+                    return s;
+                }
+                c = s[m - 1];
+            }
+            s += shift[c];
+        }
+        if ( src_end )
+            return NULL;
+        // keep the bytes not yet compared in front of the next part
+        carry = end - s;
+        memcpy( data - carry, s, carry );
+        pos += end - data;
+        buf_start = s = data - carry;
+        end = data;
+    }
+}
+
+
+static uint8_t hex_value( uint8_t c ) {
+    if ( c >= '0' && c <= '9' )
+        return c - '0';
+    if ( c >= 'A' && c <= 'F' )
+        return c - 'A' + 10;
+    return 0xFF;
+}
+
+
+// read the pattern in the footer line: text or hex bytes "C3 00 01",
+// returns its length, 0 = cancelled or invalid
+static uint8_t search_input( uint8_t text ) {
+    char in[3 * SEARCH_MAX + 1];
+    uint8_t n = 0, k, hi, lo;
+    char *s;
+
+    erase_line(); // CR, erase EOL
+    set_invers();
+    printf( text ? " FIND TEXT:" : " FIND HEX:" );
+    set_normal();
+    putchar( ' ' );
+    show_cursor();
+    while ( ( k = wait_key_hw() ) != CR ) {
+        if ( k == ESC ) {
+            n = 0;
+            break;
+        } else if ( k == BS && n ) {
+            --n;
+            printf( "\b \b" );
+        } else if ( k >= SPC && n < ( text ? SEARCH_MAX : 3 * SEARCH_MAX ) ) {
+            in[n++] = toupper( k );
+            putchar( toupper( k ) );
+        }
+    }
+    hide_cursor();
+    in[n] = '\0';
+    if ( !n )
+        return 0;
+
+    search_text = text;
+    search_len = 0;
+    if ( text ) {
+        search_len = n;
+        memcpy( search_pat, in, n );
+    } else {
+        for ( s = in; *s && search_len < SEARCH_MAX; ) {
+            if ( *s == ' ' ) {
+                ++s;
+                continue;
+            }
+            hi = hex_value( s[0] );
+            lo = hex_value( s[1] );
+            if ( hi > 15 || lo > 15 ) // also odd number of digits
+                return search_len = 0;
+            search_pat[search_len++] = ( hi << 4 ) | lo;
+            s += 2;
+        }
+    }
+    return search_len;
+}
+
+
+// end of page: ESC, 0 = next page, 1 = hit_ptr and search_hit are set or
+// 2 = not found in a decoded file, it ends there.
+// rest: the bytes of the page not shown yet, at file offset pos
+static uint8_t page_key( const char *action, const char *name,
+                         const uint8_t *rest, uint16_t rest_len, long pos, uint8_t text ) {
+    uint16_t rec = view_rec;
+    uint8_t k;
+
+    show_footer( action, name );
+    for ( ;; ) {
+        k = toupper( wait_key_hw() );
+        if ( k == ESC )
+            return ESC;
+        if ( k == 'E' && !text ) { // patch the bytes of the page
+            patch_page( pos - ( PANEL_HEIGHT + 1 ) * 16, PANEL_HEIGHT + 1, rec - 1 );
+            view_rec = rec; // continue where the page ended
+            read_record( rec, xfer_buf );
+            show_footer( action, name );
+            continue;
+        }
+        if ( k == 'F' ) {
+            if ( !search_input( text ) ) {
+                erase_line();
+                show_footer( action, name );
+                continue;
+            }
+        } else if ( k != 'N' || !search_len || search_text != text )
+            return 0; // N repeats only a pattern of the same mode (VIEW or DUMP)
+        erase_line();
+        printf( " SEARCHING... " );
+        // no rendering, the hit line is shown at the top of the next page
+        if ( ( hit_ptr = file_search( rest, rest_len, pos ) ) )
+            return 1;
+        erase_line();
+        set_invers();
+        printf( " NOT FOUND " );
+        set_normal();
+        if ( decoding ) // decoded up to the end, no way back
+            return 2;
+        view_rec = rec; // continue where the page ended
+        read_record( rec, xfer_buf );
+    }
+}
+
+
+// name "NAME.?Q?" or "NAME.?Z?"
+static uint8_t compressed_name( const char *name ) {
+    const char *ext = strchr( name, '.' );
+    return ext && ( ext[2] == 'Q' || ext[2] == 'Z' );
+}
+
+
+void view_file() {
+    // unsigned char fcb[36];
+    Panel *p = App.active_panel;
+    Panel *other = p == &App.left ? &App.right : &App.left;
+    char other_name[FILENAME_LEN];
+    int i;
+    int line_count = -1;
+    uint8_t k;
+    uint8_t borrowed = 0; // the tables are in the other panel
+    uint8_t skip = 0; // bytes of the record before the first line
+    uint8_t *pend = NULL; // decoded bytes in xfer_buf to show first
+    uint16_t pend_len = 0;
+    uint16_t n;
+    char *name_ptr = FILE_AT(p, p->current_idx).cpmname;
+    char *s;
+
+    if (p->num_files == 0 || p->mode == PM_FIND) return;
+    show_header();
+    view_rec = 0;
+    decoding = 0;
+    // open and read, a library member up to its last record
+    if (open_src(p, &FILE_AT(p, p->current_idx)) != 255) {
+        if ( compressed_name( name_ptr ) ) {
+            // the tables use the storage of the other panel, read again at the end
+            strcpy( other_name, other->num_files ? FILE_AT(other, other->current_idx).cpmname : "" );
+            borrowed = 1;
+            dcache_claim( other );
+            decoding = dec_open( (uint8_t *)other->files, MAX_FILES * ( sizeof( FileEntry ) + sizeof( uint16_t ) ) );
+            if ( !decoding ) // as it is, from the first record
+                seek_offset( 0 );
+        }
+        for (;;) {
+            // the next part: decoded bytes, or a record at 0x80
+            if ( pend_len ) {
+                s = (char *)pend;
+                n = pend_len < 128 ? pend_len : 128;
+                pend += n;
+                pend_len -= n;
+            } else if ( decoding ) {
+                s = (char *)BUF_END - 128;
+                if ( !( n = dec_read( (uint8_t *)s, 128 ) ) )
+                    break;
+            } else {
+                if ( view_rec >= src_recs || bdos(20, fcb_src) ) // BDOS function 20 (F_READ) - read next record
+                    break;
+                ++view_rec;
+                s = (char *)0x80 + skip;
+                n = 128 - skip;
+                skip = 0;
+            }
+            while (n) {
+                // print the run up to the next LF or ^Z
+                for (i = text_span(s, n); i; --i, --n)
+                    putchar(*s++);
+                if (n) {
+                    char c = *s++;
+                    --n;
+                    if (c == 0x1A) goto end_of_file; // EOF (Ctrl+Z)
+                    putchar(c); // LF
+                    putchar('\r'); // Retorno de carro para CP/M
+                    line_count++;
+                    // Pausa cuando se llena la pantalla (aprox VISIBLE_ROWS líneas)
+                    if (line_count >= PANEL_HEIGHT && !BATCH) {
+                        k = page_key( "VIEW", name_ptr, (uint8_t *)s, n + pend_len,
+                                      ( (long)( view_rec - 1 ) << 7 ) + ( s - (char *)0x80 ), 1 );
+                        if (k == ESC) goto esc_file;
+                        if (k == 2) goto end_of_file;
+                        if (k) { // the hit line at the top
+                            for ( s = (char *)hit_ptr; s > (char *)buf_start && s[-1] != '\n'; --s )
+                                ;
+                            if ( decoding ) {
+                                pend = (uint8_t *)s;
+                                pend_len = buf_end - pend;
+                            } else
+                                skip = seek_offset( search_hit - ( (char *)hit_ptr - s ) );
+                            show_header();
+                            line_count = -1;
+                            break;
+                        }
+                        erase_line(); // CR, erase EOL
+                        line_count = 0;
+                    }
+                }
+            }
+        }
+    } else {
+        printf("\r\nError opening file.");
+    }
+end_of_file:
+    printf("\r\n");
+    if ( BATCH ) // no panels to show
+        return;
+    set_invers();
+    printf(" --- End Of File --- ");
+    set_normal();
+    wait_key_hw();
+esc_file:
+    if ( borrowed )
+        reload_panel( other, other_name );
+    clrscr(); // clear screen, hide cursor
+    refresh_ui( PAN_BOTH );
+}
+
+
+// HEX and ASCII dump (16 bytes per line)
+void dump_file() {
+    Panel *p = App.active_panel;
+    int i, line_count = -1;
+    uint8_t k;
+    long address = 0;
+    uint8_t first = 0; // first line of the record
+    char line[HEX_LINE_LEN];
+    char *name_ptr = FILE_AT(p, p->current_idx).cpmname;
+
+    if (p->num_files == 0 || p->mode == PM_FIND) return;
+
+    show_header();
+    view_rec = 0;
+    decoding = 0; // the bytes of the file
+
+    if (open_src(p, &FILE_AT(p, p->current_idx)) != 255) {
+        if ( dump_at ) { // from DIFF: the line of the first difference
+            first = seek_offset( dump_at & ~15L );
+            address = dump_at & ~15L;
+            dump_at = 0;
+        }
+        while (view_rec < src_recs && bdos(20, fcb_src) == 0) { // BDOS function 20 (F_READ) - read next record
+            ++view_rec;
+            i = first;
+            first = 0;
+            for ( ; i < 128; i += 16) {
+                hex_line(line, (uint8_t *)(0x80 + i), (uint16_t)address);
+                printf("%s\r\n", line);
+
+                address += 16;
+                line_count++;
+
+                if (line_count >= PANEL_HEIGHT && !BATCH) {
+                    k = page_key( "DUMP", name_ptr, (uint8_t *)0x80 + i + 16, 112 - i, address, 0 );
+                    if (k == ESC) goto esc_file;
+                    if (k) { // the hit line at the top
+                        first = seek_offset( search_hit ) & 0x70;
+                        address = ( (long)view_rec << 7 ) + first;
+                        show_header();
+                        line_count = -1;
+                        break;
+                    }
+                    erase_line(); // CR, erase EOL
+                    line_count = 0;
+                }
+            }
+        }
+    } else {
+        printf("\r\nError opening file.");
+    }
+    printf("\r\n");
+    if ( BATCH )
+        return;
+    set_invers();
+    printf(" --- End Of File --- ");
+    set_normal();
+    wait_key_hw();
+    esc_file:
+    clrscr(); // clear screen, hide cursor
+    refresh_ui( PAN_BOTH );
+}
@@ -21,8 +21,23 @@ along with this program. If not, see <https://www.gnu.org/licenses/>.
 #include <stdint.h>
 
 #define FILENAME_LEN 13
+// fixed geometry build: -DFIXED_COLS=80 -DFIXED_LINES=24 makes the layout
+// constant, the patchable CONFIG bytes and the CP/M 3 SCB are ignored
+#if defined(FIXED_COLS) != defined(FIXED_LINES)
+#error "FIXED_COLS and FIXED_LINES go together"
+#endif
+#define STR_(x) #x
+#define STR(x) STR_(x)
+#ifdef FIXED_COLS
+#define SCREEN_WIDTH FIXED_COLS
+#define SCREEN_HEIGHT FIXED_LINES
+#define ZMC_NAME "ZMC" STR(FIXED_COLS) "X" STR(FIXED_LINES) // as built by make
+#else
+#define ZMC_NAME "ZMC"
+#define SCREEN_WIDTH (*COLUMNS) // 80
 #define SCREEN_HEIGHT (*LINES) // 32
-#define PANEL_WIDTH (*COLUMNS/2) //40
+#endif
+#define PANEL_WIDTH (SCREEN_WIDTH/2) //40
 #define PANEL_HEIGHT (SCREEN_HEIGHT - 2) // 30  // Ajustable según la terminal
 #define VISIBLE_ROWS (PANEL_HEIGHT - 2)
 
@@ -37,13 +52,38 @@ along with this program. If not, see <https://www.gnu.org/licenses/>.
 #define RUB 0x7F
 
 
-extern uint8_t *CONFIG;
+extern uint8_t CONFIG[];
 
 extern uint8_t *LINES;
 extern uint8_t *COLUMNS;
+extern uint8_t *TERM;
+extern uint8_t *CACHE;
+
+enum term_type { TERM_ANSI = 0, TERM_VT52, TERM_KAYPRO, TERM_CUSTOM, TERM_TYPES };
+
+#define CUP_ANSI 0 // ESC [ row ; col H
+#define CUP_BIN  1 // lead-in, row + offset, col + offset
+
+typedef struct { // terminal profile, NUL terminated sequences
+    uint8_t cup;     // cursor addressing: CUP_ANSI or CUP_BIN
+    uint8_t offset;  // CUP_BIN: added to zero based row and col
+    char lead[3];    // CUP_BIN: lead-in, e.g. ESC '='
+    char eeol[4];    // erase to end of line, "" -> overwrite with spaces
+    char cls[7];     // clear screen and home
+    char inv[5];     // inverse
+    char norm[5];    // normal
+    char con[7];     // cursor on
+    char coff[7];    // cursor off
+} term_profile;
+
+extern term_profile TERMS[];
 
 extern uint8_t DEBUG;
 extern uint8_t DEVEL;
+extern uint8_t PROFILE;
+extern uint8_t BATCH; // command line mode, no screen output
+
+extern uint8_t home_drive; // drive ZMC was started from, 0 = A:
 
 enum panel_type{ PAN_NONE = 0, PAN_ACTIVE, PAN_OTHER, PAN_BOTH };
 
@@ -256,18 +296,40 @@ typedef struct {
     uint8_t day;
     uint8_t hour;
     uint8_t minute;
+    uint16_t dirpos; // position in directory scan, key for unsorted order
+                     // PM_FIND: drive << 8 | user
+                     // PM_LBR: first record of the member
 } FileEntry;
 
+#define HIT_DRIVE(f) ((f)->dirpos >> 8)   // PM_FIND: drive, 0 = A:
+#define HIT_USER(f)  ((f)->dirpos & 0xFF) // PM_FIND: user number
+
+enum sort_mode { SORT_NAME = 0, SORT_EXT, SORT_SIZE, SORT_DATE, SORT_NONE, SORT_MODES };
+
+enum panel_mode { PM_DIR = 0, PM_FIND, PM_LBR };
+
 typedef struct {
-    FileEntry *files;
+    FileEntry *files; // sorted by name, extents merged
+    uint16_t *order;  // display order: row -> index into files
     uint16_t num_files;
-    uint16_t current_idx;
+    uint16_t total_files; // files on disk, more than num_files if windowed
+    uint16_t win_base; // windowed directory: files before files[0]
+    uint16_t current_idx; // row, not index into files
     uint16_t scroll_offset;
     char drive;
     uint8_t active;
     uint8_t show_date;
+    uint8_t sort; // sort_mode
+    uint8_t mode; // panel_mode
+    char pattern[FILENAME_LEN]; // PM_FIND: search pattern, PM_LBR: library
+    char filter[FILENAME_LEN]; // PM_DIR: e.g. "*.ASM", "" = all files
 } Panel;
 
+extern const char *sort_names[];
+
+// file entry shown in display row 'row' of panel 'p'
+#define FILE_AT(p, row) ((p)->files[(p)->order[row]])
+
 
 typedef struct {
     Panel left;
@@ -280,6 +342,10 @@ extern char cmdline[];
 
 extern uint16_t MAX_FILES;
 extern AppState App;
+void gotoyx( uint8_t row, uint8_t col );
+void cursor_moved( uint8_t n );
+void erase_eol( void );
+void erase_line( void );
 void set_invers( void );
 void set_normal( void );
 void show_cursor();
@@ -288,15 +354,133 @@ void clrscr( void );
 void print_cpm_attrib( uint8_t *ca );
 void draw_panel(Panel *p, uint8_t x_offset);
 void load_directory(Panel *p);
+extern uint16_t load_idle;
+uint8_t load_window(Panel *p, const char *key, uint8_t back);
+uint8_t window_next(Panel *p);
+uint8_t window_prev(Panel *p);
+void sort_panel(Panel *p);
+void days_to_date( void *date );
+void find_files( Panel *p, const char *pattern, uint8_t all_users );
+uint8_t find_jump( Panel *p );
 uint8_t wait_key_hw(void);
 int delete_file();
 int copy_file(Panel *src, Panel *dst);
 void draw_file_line(Panel *p, uint8_t x_offset, uint16_t file_idx);
 void view_file();
 void dump_file();
-int copy_file_by_index(Panel *src, Panel *dst, uint16_t idx);
-void exec_multi_copy(Panel *src, Panel *dst);
-void exec_multi_delete(Panel *p);
+#ifndef XFER_RECS
+#define XFER_RECS 16 // records of the copy transfer buffer
+#endif
+#define PLAN_DEL 0x8000 // copy plan: the file may exist on dst, delete it
+extern uint8_t xfer_buf[];
+extern uint16_t src_base;
+extern uint16_t src_recs;
+uint8_t open_src( Panel *p, FileEntry *f );
+uint8_t partial_close( uint8_t *fcb );
+int copy_file_by_index(Panel *src, Panel *dst, uint16_t idx, uint8_t del);
+int find_file( Panel *p, const char *name );
+uint8_t goto_file( Panel *p, const char *name );
+void reload_panel( Panel *p, const char *name );
+int exec_multi_copy(Panel *src, Panel *dst);
+#define FAN_MAX 8 // destination drives of a fan-out copy
+uint8_t fan_drives( const char *arg, char *drives, char src );
+int exec_fan_copy( Panel *src, Panel *dst, const char *drives );
+int exec_multi_delete(Panel *p);
+#define CMP_WINDOWED 0xFFFF // compare_panels(): a panel has only a window
+uint16_t compare_panels( Panel *src, Panel *dst, uint8_t both );
+void show_progress( const char *action, int n, int total, const char *name );
+int batch( int argc, char **argv );
+void batch_exit( int status );
+uint8_t lbr_open( Panel *p );
+void lbr_close( Panel *p );
+void patch_page( long start, uint8_t lines, uint16_t cur_rec );
+extern long dump_at;
+long diff_files( Panel *a, Panel *b, uint16_t *recs );
+// diskcopy.c: BIOS disk access, DISKCOPY
+#define DPB_LEN 17 // CP/M 3: PSH and PHM after the CP/M 2.2 fields
+#define B_READ  13 // BIOS functions for disk_sector()
+#define B_WRITE 14
+extern uint16_t disk_nsec;
+extern uint16_t disk_sec_size;
+uint8_t disk_dpb( uint8_t drv, uint8_t *dpb );
+uint16_t disk_select( uint8_t drv, uint8_t first );
+uint8_t disk_sector( uint8_t func, uint16_t trk, uint16_t sec, uint8_t *buf,
+                     uint16_t xlt, uint8_t wtype );
+enum dc_error { DC_FORMAT = 1, DC_MEMORY, DC_SELECT, DC_READ, DC_WRITE, DC_VERIFY };
+int disk_copy( uint8_t src, uint8_t dst, uint8_t verify, uint16_t *trk );
+void disk_copy_done( uint8_t dst );
+void disk_map( Panel *p );
+// qview.c: QUICK VIEW of the current file in the other panel
+extern uint8_t qview;
+void qview_open( void );
+void qview_close( void );
+void qview_draw( void );
+void qview_update( void );
+// unsq.c: SQ and Crunch decoders of the viewer
+enum dec_type { DEC_RAW = 0, DEC_SQ, DEC_CRUNCH };
+uint8_t dec_open( uint8_t *mem, uint16_t size );
+uint16_t dec_read( uint8_t *buf, uint16_t max );
+void shell_out( const char *cmd );
+uint8_t shell_resume( void );
+uint16_t disk_print( uint8_t drv );
+// dcache.c: directory cache, idle prefetch
+uint8_t key_ready( void );
+void dcache_init( void );
+void dcache_claim( Panel *p );
+void dcache_loaded( Panel *p );
+void dcache_used( char drive );
+uint8_t dcache_switch( Panel *p, char drive );
+uint8_t dcache_idle( void );
+// kernels.c: hot loops in Z80 assembler, C versions with -DNOASM
+#define HEX_LINE_LEN 75 // "AAAA  " 16 x "HH " " |" 16 chars "|" NUL
+extern const char hex_digits[];
+int name_cmp( const char *a, const char *b );
+void dir_name( char *dst, const uint8_t *src );
+void hex_line( char *buf, const uint8_t *data, uint16_t addr );
+uint8_t text_span( const char *s, uint8_t n );
+uint16_t bdos_hl( uint8_t func, uint16_t arg );
+uint16_t bios_direct( uint8_t func, uint16_t bc, uint16_t de );
 void show_prompt( void );
 void refresh_ui(uint8_t which_panel);
+void help( void );
+void key_test( void );
+void show_config( void );
+
+// --PROFILE counters, see profile.c
+extern uint16_t prof_full;
+extern uint16_t prof_part;
+void prof_start( void );
+void prof_begin( void );
+void prof_end( void );
+void prof_stop( void );
+
+extern uint8_t fcb_src[];
+extern uint8_t fcb_dst[];
+void prepare_fcb( char *name, Panel *src, Panel *dst );
+void name_to_fcb( uint8_t *fcbname, const char *name );
+uint8_t match_name( const uint8_t *pattern, const char *name );
+
+// Overlays: with -DOVERLAYS the rarely used modules are not resident,
+// they are linked to ovl_area and loaded from ZMC.OVR on demand.
+// Modules compiled as overlay (-DOVL_MODULE) call the real functions.
+enum overlay { OVL_ROOT = 0, OVL_HELP, OVL_VIEWER, OVL_MAX = 16 };
+
+#ifdef OVERLAYS
+#ifndef OVL_SIZE
+#define OVL_SIZE 4096 // size of the shared overlay region
+#endif
+extern uint8_t ovl_area[];
+void ovl_open( void );
+int ovl_call( uint8_t ovl, uint8_t fn, void *arg );
+void ovl_info( void );
+
+#ifndef OVL_MODULE
+#define help()        ovl_call( OVL_HELP, 0, NULL )
+#define key_test()    ovl_call( OVL_HELP, 1, NULL )
+#define show_config() ovl_call( OVL_HELP, 2, NULL )
+#define view_file()   ovl_call( OVL_VIEWER, 0, NULL )
+#define dump_file()   ovl_call( OVL_VIEWER, 1, NULL )
+#endif
+#endif
+
 #endif